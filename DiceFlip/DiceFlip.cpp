@@ -2,463 +2,972 @@
 #include <vector>
 #include "types.h"
 #include <string>
-#include <fstream>
+#include <sstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <stdio.h>
+#include <csignal>
+#include "game.h"
+#include "transposition.h"
+#include "minimax.h"
+#include "dpsolver.h"
+#include "solutiondb.h"
+#include "verify.h"
+#include "resultswriter.h"
+#include "montecarlo.h"
+#include "variantsolver.h"
+#include "ttpersist.h"
+#include "distributed.h"
+#include "server.h"
 
-#define AUTOINPUT
+/**
+ * If defined, the evaluations and best moves of every game are looked up from a solution database. It is solved bottom-up by
+ * `solveDP` and written to `SOLUTION_DB_PATH` once, later runs only map the existing database into memory. A database covering
+ * fewer totals, e.g. from a build with a smaller `TOTAL_LIMIT`, is extended by the missing totals instead of being solved again
+ */
+#define DP_SOLVER
 
 /**
- * The output file where some results can be written to
+ * If defined, the games are solved and played on a pool of worker threads. Every worker owns its own transposition table unless
+ * `SHARED_TT` is defined in `config.h`. The results are written in the same order as in the single threaded sweep. Interactive
+ * games are always played on the main thread
  */
-static std::ofstream file;
+#define PARALLEL_SWEEP
 
 /**
- * The maximum number of GameStates. The hash function must guarantee 1-universality in {0, 1, ..., NUM_GAME_STATES}.
+ * If defined, the transposition table backed search is verified against `solveDP` on every starting state of the sweep before
+ * the games are played, see `verifySearch`, and so is `searchBatch` on every state, see `verifyBatchSearch`. The batch
+ * operations are checked against the scalar ones and the solvers against each other first, see `verifyBatchOperations` and
+ * `verifyDPSolvers`. The sweep is skipped if a verification fails
  */
-static constexpr unsigned long long NUM_GAME_STATES = 4294967296;
+//#define VERIFY_TT
 
 /**
- * The datatype representing a player. -1 for player 1, 1 for player 2
+ * The format the results of the sweep are written in unless another one is given on the command line, see `ResultsFormat`. The
+ * file is named after the format by `getResultsPath`
  */
-typedef int8 Player;
+#define RESULTS_FORMAT RESULTS_FORMAT_LEGACY
 
 /**
- * The datatype representing a move. Values are {1, 2, ..., 6} corresponding to the number the dice is showing
+ * The datatype representing what a run of the program does. It is selected by the first command line argument.
+ * 0: SELFPLAY, every game of the sweep is solved and played by the computer against itself
+ * 1: TABLE, only the evaluations of the sweep are computed, without playing the games and without console output
+ * 2: INTERACTIVE, every game of the sweep is solved and played against the user on the console
+ * 3: MONTECARLO, many games are played from every starting position of the sweep between two policies, see `runMonteCarlo`
+ * 4: VARIANTS, the rule variants of `DiceRules` are solved for the starting totals of the sweep, see `reportVariant`
+ * 5: RANGE, one range of totals of a solve split into ranges is solved on top of the range below, see `solveRangeNode`
+ * 6: MERGE, the ranges of a solve split into ranges are merged into the solution database, see `mergeVariantRanges`
+ * 7: SERVE, the moves and evaluations of the solution database are served over TCP until interrupted, see `runMoveServer`
  */
-typedef uint8 Move;
+typedef uint8 RunMode;
 
 /**
- * The datatype representing a node type used for alpha-beta-pruning.
- * 1: EXACT
- * 2: LOWER
- * 3: UPPER
+ * Constant representing the SELFPLAY run mode
  */
-typedef uint8 NodeType;
+static constexpr RunMode RUN_MODE_SELFPLAY = 0;
 
 /**
- * Constant representing the EXACT node type
+ * Constant representing the TABLE run mode
  */
-static constexpr NodeType NODE_TYPE_EXACT = 1;
+static constexpr RunMode RUN_MODE_TABLE = 1;
 
 /**
- * Constant representing the LOWER node type
+ * Constant representing the INTERACTIVE run mode
  */
-static constexpr NodeType NODE_TYPE_LOWER = 2;
+static constexpr RunMode RUN_MODE_INTERACTIVE = 2;
 
 /**
- * Constant representing the UPPER node type
+ * Constant representing the MONTECARLO run mode
  */
-static constexpr NodeType NODE_TYPE_UPPER = 3;
+static constexpr RunMode RUN_MODE_MONTECARLO = 3;
 
 /**
-* Represents a complete GameState. Note that 'winner' is set to zero for optimization reasons if no winner is set even though the value is not
-* specified by the Player type.
-*/
-typedef struct _GameState {
-	Move lastMove;
-	int8 total;
-	Player activePlayer;
-	Player winner;
-} GameState;
+ * Constant representing the VARIANTS run mode
+ */
+static constexpr RunMode RUN_MODE_VARIANTS = 4;
 
 /**
- * The transposition table used to avoid unnecessary calculations.
- * The n-th entry in the table corresponds to the GameState with the hash value n. Note that this calculation is collision-free due
- * to the hash function being bijective.
- * Values of the transposition table are bitmasks in the form
- * AAAAAAAABBCCCCCC, where
- * A is the evaluation depth of the entry
- * B is the node type and
- * C is the evaluation
+ * Constant representing the RANGE run mode
  */
-static uint16* transpositionTable = nullptr;
+static constexpr RunMode RUN_MODE_RANGE = 5;
 
 /**
-* The hash function for GameState. Hash values are used to reference entries of the transposition table
-*/
-static inline constexpr uint32 hash(const GameState& state) noexcept
-{
-	uint32 out = 0;
-	return out
-		| (static_cast<uint8>(state.total + 128))
-		| (static_cast<uint8>(state.activePlayer + 128) << 8)
-		| (static_cast<uint8>(state.winner + 128) << 16)
-		| (state.lastMove << 24);
-}
+ * Constant representing the MERGE run mode
+ */
+static constexpr RunMode RUN_MODE_MERGE = 6;
 
 /**
- * Creates a transposition table entry value. See the definition of `transpositionTable` for details
+ * Constant representing the SERVE run mode
  */
-static inline constexpr uint16 makeTTVal(const uint8& depth, const int8& eval, const NodeType& type)
-{
-	return (static_cast<uint16>(depth) << 8)
-		| (static_cast<NodeType>(type) << 6)
-		| (static_cast<uint8>(eval));
-}
+static constexpr RunMode RUN_MODE_SERVE = 7;
 
 /**
- * Extracts the depth value from a transposition table entry
+ * The number of games played from every starting position in the `RUN_MODE_MONTECARLO` unless another one is given
  */
-static inline constexpr uint8 getDepth(uint32 hash) noexcept
-{
-	return transpositionTable[hash] >> 8;
-}
+static constexpr uint64 DEFAULT_MONTECARLO_GAMES = 100000;
 
 /**
- * Extracts the evaluation value from a transposition table entry
+ * The options of a run, see `parseOptions`
  */
-static inline constexpr int8 getRating(uint32 hash) noexcept
+typedef struct _Options {
+	RunMode mode;
+	ResultsFormat format;
+	bool quiet;
+	bool warmTT;
+	uint64 games;
+	uint64 seed;
+	PolicyType policies[2];
+	uint8 depths[2];
+	uint64 fromTotal;
+	uint64 toTotal;
+	uint64 port;
+	std::vector<std::string> files;
+} Options;
+
+/**
+ * Writes the command line usage to `out`
+ */
+static void printUsage(std::ostream& out, const char* program)
 {
-	return static_cast<int8>(transpositionTable[hash] & 0b111111);
+	out << "Usage: " << program << " [selfplay|table|interactive|montecarlo|variants|range|merge|serve] [OPTION...]\n"
+		<< "       " << program << " [selfplay|table|interactive] [--quiet] [--format=legacy|jsonl|csv|binary] [--warm-tt]\n"
+		<< "       " << program << " montecarlo [--quiet] [--warm-tt] [--games=N] [--policies=A,B] [--seed=N]\n"
+		<< "       " << program << " variants\n"
+		<< "       " << program << " range --from=A --to=B\n"
+		<< "       " << program << " merge FILE...\n"
+		<< "       " << program << " serve [--port=N]\n"
+		<< "  selfplay     Solves every game of the sweep and lets the computer play it against itself (default)\n"
+		<< "  table        Only computes the evaluation table, without playing and without console output\n"
+		<< "  interactive  Solves every game of the sweep and plays it against you\n"
+		<< "  montecarlo   Plays many games from every starting position and prints the win rate of the starting player\n"
+		<< "  variants     Solves the rule variants for other dice and prints how many starting positions the starting player wins\n"
+		<< "  range        Solves the totals A to B on top of the boundary the range below them wrote, one range after another\n"
+		<< "  merge        Merges the range files of every range into the solution database\n"
+		<< "  serve        Serves the moves and evaluations of the solution database over TCP until interrupted\n"
+		<< "  --quiet      Plays the self-play games without console output, only prints the summary in montecarlo\n"
+		<< "  --format     The format of the results file, legacy by default\n"
+		<< "  --warm-tt    Starts the transposition tables from " << TT_FILE_PATH << " and saves them there at the end.\n"
+		<< "               Only applies to searches, so the sweep with the solution database and most modes ignore it\n"
+		<< "  --games      The number of montecarlo games per starting position, " << DEFAULT_MONTECARLO_GAMES << " by default\n"
+		<< "  --policies   The montecarlo policies of the starting player and its opponent, perfect,random by default.\n"
+		<< "               Each is one of perfect, random, greedy or minimax<depth>, e.g. minimax4\n"
+		<< "  --seed       The seed of the montecarlo games, 1 by default\n"
+		<< "  --port       The port of serve, " << DEFAULT_SERVER_PORT << " by default. Every request is a line of\n"
+		<< "               \"move <total> <dice>\" or \"eval <total> <dice>\", answered by the best move or the evaluation\n";
 }
 
 /**
- * Extracts the node type from a transposition table entry
+ * Parses the policy `name` into its `type` and `depth`. Returns false if it is not a policy, see `printUsage`
  */
-static inline constexpr NodeType getNodeType(uint32 hash) noexcept
+static bool parsePolicy(const std::string& name, PolicyType& type, uint8& depth)
 {
-	return static_cast<NodeType>((transpositionTable[hash] >> 6) & 0b11);
+	depth = 0;
+
+	if (name == "perfect")
+		type = POLICY_PERFECT;
+	else if (name == "random")
+		type = POLICY_RANDOM;
+	else if (name == "greedy")
+		type = POLICY_GREEDY;
+	else if (name.compare(0, 7, "minimax") == 0 && name.size() > 7 && name.size() <= 10
+		&& name.find_first_not_of("0123456789", 7) == std::string::npos)
+	{
+		int value = std::stoi(name.substr(7));
+		if (value < 1 || value > 255)
+			return false;
+
+		type = POLICY_MINIMAX;
+		depth = static_cast<uint8>(value);
+	}
+	else
+		return false;
+
+	return true;
 }
 
 /**
- * Creates a new game state where nobody is the winner yet
+ * Parses the decimal number `text` into `value`. Returns false if it is not a number
  */
-static constexpr GameState createGameState(const Move& lastMove, const Player& player, const int8& total) noexcept
+static bool parseNumber(const std::string& text, uint64& value)
 {
-	return GameState{lastMove, total, player, 0};
+	if (text.empty() || text.size() > 19 || text.find_first_not_of("0123456789") != std::string::npos)
+		return false;
+
+	value = std::stoull(text);
+	return true;
 }
 
 /**
- * Returns a random number in {1, 2, ..., 6}
+ * Parses the command line arguments into `options`. Returns false if they are invalid
  */
-static inline uint8 rollDice()
+static bool parseOptions(const int& argc, char** argv, Options& options)
 {
-	return (rand() % 6) + 1;
+	options.mode = RUN_MODE_SELFPLAY;
+	options.format = RESULTS_FORMAT;
+	options.quiet = false;
+	options.warmTT = false;
+	options.games = DEFAULT_MONTECARLO_GAMES;
+	options.seed = 1;
+	options.policies[0] = POLICY_PERFECT;
+	options.policies[1] = POLICY_RANDOM;
+	options.depths[0] = 0;
+	options.depths[1] = 0;
+	options.fromTotal = 0;
+	options.toTotal = 0;
+	options.port = DEFAULT_SERVER_PORT;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string arg = argv[i];
+
+		if (i == 1 && arg == "selfplay")
+			options.mode = RUN_MODE_SELFPLAY;
+		else if (i == 1 && arg == "table")
+			options.mode = RUN_MODE_TABLE;
+		else if (i == 1 && arg == "interactive")
+			options.mode = RUN_MODE_INTERACTIVE;
+		else if (i == 1 && arg == "montecarlo")
+			options.mode = RUN_MODE_MONTECARLO;
+		else if (i == 1 && arg == "variants")
+			options.mode = RUN_MODE_VARIANTS;
+		else if (i == 1 && arg == "range")
+			options.mode = RUN_MODE_RANGE;
+		else if (i == 1 && arg == "merge")
+			options.mode = RUN_MODE_MERGE;
+		else if (i == 1 && arg == "serve")
+			options.mode = RUN_MODE_SERVE;
+		else if (options.mode == RUN_MODE_MERGE && arg.compare(0, 2, "--") != 0)
+			options.files.push_back(arg);
+		else if (arg.compare(0, 7, "--from=") == 0)
+		{
+			if (!parseNumber(arg.substr(7), options.fromTotal) || options.fromTotal == 0)
+				return false;
+		}
+		else if (arg.compare(0, 5, "--to=") == 0)
+		{
+			if (!parseNumber(arg.substr(5), options.toTotal))
+				return false;
+		}
+		else if (arg.compare(0, 7, "--port=") == 0)
+		{
+			if (!parseNumber(arg.substr(7), options.port) || options.port == 0 || options.port > 65535)
+				return false;
+		}
+		else if (arg == "--quiet")
+			options.quiet = true;
+		else if (arg == "--warm-tt")
+			options.warmTT = true;
+		else if (arg == "--format=legacy")
+			options.format = RESULTS_FORMAT_LEGACY;
+		else if (arg == "--format=jsonl")
+			options.format = RESULTS_FORMAT_JSONL;
+		else if (arg == "--format=csv")
+			options.format = RESULTS_FORMAT_CSV;
+		else if (arg == "--format=binary")
+			options.format = RESULTS_FORMAT_BINARY;
+		else if (arg.compare(0, 8, "--games=") == 0)
+		{
+			if (!parseNumber(arg.substr(8), options.games) || options.games == 0)
+				return false;
+		}
+		else if (arg.compare(0, 7, "--seed=") == 0)
+		{
+			if (!parseNumber(arg.substr(7), options.seed))
+				return false;
+		}
+		else if (arg.compare(0, 11, "--policies=") == 0)
+		{
+			size_t comma = arg.find(',', 11);
+			if (comma == std::string::npos
+				|| !parsePolicy(arg.substr(11, comma - 11), options.policies[0], options.depths[0])
+				|| !parsePolicy(arg.substr(comma + 1), options.policies[1], options.depths[1]))
+				return false;
+		}
+		else
+			return false;
+	}
+
+	if (options.mode == RUN_MODE_RANGE && (options.fromTotal == 0 || options.toTotal < options.fromTotal
+		|| options.toTotal > static_cast<uint64>(INT64_MAX) / 4))
+		return false;
+
+	if (options.mode == RUN_MODE_MERGE && options.files.empty())
+		return false;
+
+	// 
+	// The prompts of interactive games must not be hidden
+	// 
+
+	return !(options.quiet && options.mode == RUN_MODE_INTERACTIVE);
 }
 
 /**
- * Performs the given `Move` on the given `GameState` and returns the resulting `GameState`
+ * The results of the sweep. They are collected in memory and written to the results file at once
  */
-static inline constexpr GameState performMove(const GameState& state, const Move& move) noexcept
+static ResultsWriter results;
+
+
+/**
+ * Evaluates the game starting at `startState` from the point of view of the computer
+ */
+static int8 evaluateStartState(const GameState& startState)
 {
-	int8 newTotal = state.total - move;
-	return GameState{
-		move,
-		static_cast<int8>(newTotal),
-		static_cast<Player>(-state.activePlayer),
-		static_cast<Player>((newTotal <= 0) * (-state.activePlayer))};
+	int8 eval = evaluateState(startState, 100);
+	return startState.activePlayer == -1 ? -eval : eval;
 }
 
 /**
- * Performs every valid move on the given `GameState` and writes the results in the `out` array
+ * Solves and plays the game starting at `startState` and writes the console output to `out`. The user's moves are read from
+ * std::cin unless `autoInput` is set, in which case the computer makes them. The evaluation of the game from the point of view of
+ * the computer is written to `eval`. Returns false if the game did not end as evaluated.
  */
-static inline void getPossibleStates(GameState out[4], const GameState& lastState)
-{	
-	switch (lastState.lastMove)
-	{
-	case 6:
-	case 1:
+static bool playSweepGame(const GameState& startState, int8& eval, std::ostream& out, const bool& autoInput)
+{
+#ifdef SEARCH_STATS
+	SearchStats statsBefore = searchStats;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+#endif // SEARCH_STATS
+
+	// 
+	// Game Initialization
+	//
+
+	out << "Starting total: " << static_cast<int>(startState.total) << "\n";
+	out << "Dice shows: " << static_cast<int>(startState.lastMove) << "\n";
+
+	GameState curState = startState;
+
+	// 
+	// Computer flexes its abilites
+	// 
+
+	eval = evaluateStartState(curState);
+
+	out << "[" << static_cast<int>(eval) << "] The computer already knows " << (eval > 0 ? "it" : (eval < 0 ? "you" : "nobody")) << " will win if played perfectly.\n";
+
+	if (startState.activePlayer == 1)
+		out << "Computer starts.\n";
+	else
+		out << "You start.\n";
+
+	// 
+	// Game starts
+	// 
+
+	while (curState.winner == 0)
 	{
-		out[0] = performMove(lastState, 5);
-		out[1] = performMove(lastState, 4);
-		out[2] = performMove(lastState, 3);
-		out[3] = performMove(lastState, 2);
-		return;
+		if (curState.activePlayer == 1)
+		{
+			// 
+			// Computer's turn
+			// 
+
+			curState = makeBestMove(curState);
+
+			out << "[" << static_cast<int>(evaluateState(curState, 63)) << "] The computer turns to " << static_cast<int>(curState.lastMove) << ".New total is " << static_cast<int>(curState.total) << "\n";
+
+		}
+		else
+		{
+			// 
+			// Player's turn
+			// 
+
+			Move move = '?';
+
+			if (!autoInput)
+			{
+				out << "Your move: " << std::flush;
+				std::cin >> move;
+			}
+
+			if (move == '?')
+			{
+				// 
+				// Automatically make best move if player enters '?' or autoinput is active
+				// 
+
+				GameState bestState = makeBestMove(curState);
+
+				out << "(You move " << static_cast<int>(bestState.lastMove) << ")\n";
+				move = bestState.lastMove;
+			}
+			else
+			{
+				// 
+				// Translate ASCII to move
+				// 
+
+				move -= '0';
+			}
+
+			// 
+			// Check move validity
+			// 
+
+			if (!isLegalMove(curState.lastMove, move))
+			{
+				out << "## Your move is invalid ##\n";
+				continue;
+			}
+
+			// 
+			// Perform the move
+			// 
+
+			curState = performMove(curState, move);
+		}
 	}
-	case 5:
-	case 2:
+
+	bool consistent = true;
+
+	if (curState.winner == 1)
 	{
-		out[0] = performMove(lastState, 6);
-		out[1] = performMove(lastState, 4);
-		out[2] = performMove(lastState, 3);
-		out[3] = performMove(lastState, 1);
-		return;
+		out << "Computer wins.\n";
+		if (eval < 1)
+		{
+			out << "huh?";
+			consistent = false;
+		}
 	}
-	case 4:
-	case 3:
+	else if (curState.winner == -1)
 	{
-		out[0] = performMove(lastState, 6);
-		out[1] = performMove(lastState, 5);
-		out[2] = performMove(lastState, 2);
-		out[3] = performMove(lastState, 1);
-		return;
-	}
+		out << "You win.\n";
+
+		if (eval > -1)
+		{
+			out << "huh?";
+			consistent = false;
+		}
 	}
+
+#ifdef SEARCH_STATS
+	// 
+	// Report the search work done for this game
+	// 
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	out << "[stats] " << formatSearchStats(subtractSearchStats(searchStats, statsBefore), seconds) << "\n";
+#endif // SEARCH_STATS
+
+	return consistent;
 }
 
 /**
- * Evaluates the plain state as a base case of the minimax recursion
+ * A single game of the sweep
  */
-static inline int8 eval(const GameState& state)
+typedef struct _SweepGame {
+	GameState startState;
+	int8 eval;
+	bool consistent;
+	std::string log;
+} SweepGame;
+
+/**
+ * Runs the `game` as selected by `options` and writes its console output to `out`. In the `RUN_MODE_TABLE` the game is only
+ * evaluated, otherwise it is played by `playSweepGame`
+ */
+static void runSweepGame(SweepGame& game, const Options& options, std::ostream& out)
 {
-	return (state.total <= 0) * state.winner;
+	if (options.mode == RUN_MODE_TABLE)
+	{
+		game.eval = evaluateStartState(game.startState);
+		game.consistent = true;
+		return;
+	}
+
+	game.consistent = playSweepGame(game.startState, game.eval, out, options.mode != RUN_MODE_INTERACTIVE);
 }
 
 /**
- * Performs the minimax algorithm on the `curState` with a maximum depth of `depth`. `alpha` and `beta` values are used for
- * alpha-beta-pruning. The first call should pass the minimum evaluation value for `alpha` and the maximum evaluation value for `beta`
+ * Runs the games in `games` one after another on the calling thread and writes their console output to std::cout right away.
+ * Stops after the first game that did not end as evaluated. Returns the number of games that were run
  */
-static int8 miniMax(const GameState& curState, const uint8& depth, int8 alpha, int8 beta)
+static size_t sweepSerial(std::vector<SweepGame>& games, const Options& options)
 {
 	// 
-	// Check if base case applies
+	// A stream without a buffer discards everything written to it
 	// 
-	if (depth == 0 || curState.total <= 0)
-		return curState.activePlayer * eval(curState);
 
-	int8 max = -1;
+	std::ostream discard(nullptr);
+	std::ostream& out = options.quiet || options.mode == RUN_MODE_TABLE ? discard : std::cout;
 
-	const Player player = curState.activePlayer;
+	for (size_t i = 0; i < games.size(); i++)
+	{
+		runSweepGame(games[i], options, out);
+		if (!games[i].consistent)
+			return i + 1;
+	}
 
-	GameState gameStates[4];
-	getPossibleStates(gameStates, curState);
+	return games.size();
+}
 
-	// 
-	// Check possible next states
-	// 
+#ifdef PARALLEL_SWEEP
+/**
+ * Runs every game in `games` on `numThreads` worker threads. Every worker takes the next game until all of them are done. The
+ * console output of every game is kept in its `log`. The workers use their own transposition tables, or the lock-free shared one
+ * if `SHARED_TT` is defined. The search counters of all workers are added to `stats`. Own tables start with the entries of
+ * `warmStart` and are merged into `warmEnd` when the worker is done, see `TTSnapshot`. Both are ignored if they are empty or
+ * nullptr
+ */
+static void sweepParallel(std::vector<SweepGame>& games, const Options& options, const unsigned& numThreads, SearchStats& stats,
+	const TTSnapshot& warmStart, TTSnapshot* warmEnd)
+{
+	std::atomic<size_t> nextGame(0);
+	std::vector<std::thread> workers;
+	std::vector<SearchStats> workerStats(numThreads);
+	std::mutex warmEndMutex;
 
-	for(uint8 i = 0; i < 4; i++)
+	for (unsigned t = 0; t < numThreads; t++)
 	{
-		GameState possibleNext = gameStates[i];
-
-		// 
-		// Transposition table lookup
-		// 
-
-		uint32 hashVal = hash(possibleNext);
-		uint8 ttDepth = getDepth(hashVal);
-		if (ttDepth > 0)
+		workers.emplace_back([&games, &options, &nextGame, &workerStats, &warmStart, warmEnd, &warmEndMutex, t]()
 		{
-			if (ttDepth >= depth)
+#ifndef SHARED_TT
+			allocateTranspositionTable();
+			applyTTSnapshot(warmStart);
+#else
+			(void)warmStart;
+			(void)warmEnd;
+			(void)warmEndMutex;
+#endif // SHARED_TT
+
+			std::ostream discard(nullptr);
+			const bool silent = options.quiet || options.mode == RUN_MODE_TABLE;
+
+			for (size_t i = nextGame++; i < games.size(); i = nextGame++)
 			{
-				int8 eval = getRating(hashVal);
-
-				switch (getNodeType(hashVal))
-				{
-				case NODE_TYPE_LOWER:
-				{
-					if (eval > alpha)
-						alpha = eval;
-				} break;
-				case NODE_TYPE_UPPER:
-				{
-					if (eval < beta)
-						beta = eval;
-				} break;
-				case NODE_TYPE_EXACT:
+				if (silent)
 				{
-					return eval;
-				}
+					runSweepGame(games[i], options, discard);
+					continue;
 				}
 
-				if (alpha >= beta)
-				{
-					return eval > max ? eval : max;
-				}
+				std::ostringstream log;
+				runSweepGame(games[i], options, log);
+				games[i].log = log.str();
 			}
-		}
 
-		// 
-		// Perform minimax
-		// 
+			workerStats[t] = getSearchStats();
 
-		int8 val = -miniMax(possibleNext, depth - 1, alpha, beta);
-		if (val > max)
-		{
-			max = val;
-		}
+#ifndef SHARED_TT
+			if (warmEnd != nullptr)
+			{
+				std::lock_guard<std::mutex> lock(warmEndMutex);
+				mergeTTSnapshot(*warmEnd);
+			}
 
-		// 
-		// Update transposition table
-		// 
+			freeTranspositionTable();
+#endif // SHARED_TT
+		});
+	}
 
-		if(val <= alpha)
-			transpositionTable[hashVal] = makeTTVal(depth, val, NODE_TYPE_UPPER);
-		else if (val >= beta)
-			transpositionTable[hashVal] = makeTTVal(depth, val, NODE_TYPE_LOWER);
-		else
-		{
-			uint8 uVal = static_cast<uint8>(val + 128);
+	for (std::thread& worker : workers)
+		worker.join();
 
-			transpositionTable[hashVal] = makeTTVal(depth, val, NODE_TYPE_EXACT);
-		}
+	for (const SearchStats& worker : workerStats)
+		mergeSearchStats(stats, worker);
+}
+#endif // PARALLEL_SWEEP
+
+/**
+ * Returns the name of the policy of the given `type` and `depth` as it is given on the command line
+ */
+static std::string formatPolicy(const PolicyType& type, const uint8& depth)
+{
+	switch (type)
+	{
+	case POLICY_PERFECT:
+		return "perfect";
+	case POLICY_RANDOM:
+		return "random";
+	case POLICY_GREEDY:
+		return "greedy";
+	default:
+		return "minimax" + std::to_string(depth);
 	}
+}
+
+/**
+ * Plays the Monte-Carlo games of the `RUN_MODE_MONTECARLO` from every state of `startStates` on every core and writes the win
+ * rates of the starting player and the throughput to `out`. The policies are built on the calling thread, which must own a
+ * transposition table for `POLICY_MINIMAX`
+ */
+static void runMonteCarloMode(const std::vector<GameState>& startStates, const Options& options, std::ostream& out)
+{
+	Total maxTotal = 0;
+	for (const GameState& state : startStates)
+		if (state.total > maxTotal)
+			maxTotal = state.total;
+
+	Policy policies[2];
+	for (uint8 i = 0; i < 2; i++)
+		buildPolicy(policies[i], options.policies[i], options.depths[i], maxTotal);
+
+	std::vector<MonteCarloResult> results(startStates.size());
+	for (size_t i = 0; i < startStates.size(); i++)
+		results[i].startState = startStates[i];
+
+	unsigned numThreads = std::thread::hardware_concurrency();
 
-	return max;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	runMonteCarlo(results, policies[0], policies[1], options.games, numThreads > 0 ? numThreads : 1, options.seed);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	out << "[montecarlo] " << formatPolicy(options.policies[0], options.depths[0]) << " starts against "
+		<< formatPolicy(options.policies[1], options.depths[1]) << ", " << options.games << " games per starting position\n";
+
+	uint64 games = 0;
+	uint64 played = 0;
+	char line[96];
+	for (const MonteCarloResult& result : results)
+	{
+		games += result.games;
+		played += result.played;
+		if (options.quiet)
+			continue;
+
+		snprintf(line, sizeof(line), "Total %d, dice %d: the starting player wins %.3f%%\n", static_cast<int>(result.startState.total),
+			static_cast<int>(result.startState.lastMove), 100.0 * result.starterWins / result.games);
+		out << line;
+	}
+
+	out << "[montecarlo] " << games << " games, " << played << " of them played in " << seconds << "s (" << played / seconds << " games/s)\n";
 }
 
 /**
- * Chooses the best move and performs it.
+ * Solves every combination of the rules of `DiceRules` for dice with 4 to 20 faces in the `RUN_MODE_VARIANTS` and writes how
+ * many starting positions of the sweep the starting player wins to `out`. Needs neither a transposition table nor the solution
+ * database
  */
-GameState makeBestMove(const GameState& curState)
+static void runVariantsMode(std::ostream& out)
 {
-	static GameState nextPossible[4];
-	getPossibleStates(nextPossible, curState);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	reportDiceVariants<4>(out, 11, 66);
+	reportDiceVariants<6>(out, 11, 66);
+	reportDiceVariants<8>(out, 11, 66);
+	reportDiceVariants<10>(out, 11, 66);
+	reportDiceVariants<12>(out, 11, 66);
+	reportDiceVariants<20>(out, 11, 66);
 
-	int8 max = -2;
-	uint8 maxI = 0xFF;
+	out << "[variants] Solved in " << std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s\n";
+}
 
-	for (uint8 i = 0; i < 4; i++)
+/**
+ * Solves one range of totals of DiceFlip in the `RUN_MODE_RANGE` and writes what it did to `out`. Returns false if the range
+ * could not be solved
+ */
+static bool runRangeMode(const Options& options, std::ostream& out)
+{
+	const int64 firstTotal = static_cast<int64>(options.fromTotal);
+	const int64 lastTotal = static_cast<int64>(options.toTotal);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	if (!solveRangeNode<StandardRules>(firstTotal, lastTotal))
 	{
-		int8 evaluation = -miniMax(nextPossible[i], 100, -128, 127);
+		out << "[range] Could not solve the totals " << firstTotal << " to " << lastTotal << ", " << getBoundaryPath(firstTotal)
+			<< " of the range below is missing or invalid, or the files could not be written.\n";
+		return false;
+	}
 
-		if (evaluation >= max)
+	out << "[range] Solved the totals " << firstTotal << " to " << lastTotal << " in "
+		<< std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() << "s, wrote "
+		<< getRangePath(firstTotal, lastTotal) << " and the boundary " << getBoundaryPath(lastTotal + 1) << " for the next range\n";
+	return true;
+}
+
+/**
+ * Merges the range files of a solve of DiceFlip split into ranges in the `RUN_MODE_MERGE` into the solution database at
+ * `SOLUTION_DB_PATH` and writes what it did to `out`. Returns false if the ranges do not fit together
+ */
+static bool runMergeMode(const Options& options, std::ostream& out)
+{
+	std::vector<VariantRange> ranges(options.files.size());
+	for (size_t i = 0; i < options.files.size(); i++)
+	{
+		if (!readVariantRange<StandardRules>(options.files[i].c_str(), ranges[i]))
 		{
-			max = evaluation;
-			maxI = i;
+			out << "[merge] " << options.files[i] << " is not a valid range file.\n";
+			return false;
 		}
 	}
 
-	if (max == -2)
-		return nextPossible[0];
+	VariantRange merged;
+	if (!mergeVariantRanges<StandardRules>(merged, ranges))
+	{
+		out << "[merge] The ranges leave a gap or disagree.\n";
+		return false;
+	}
+
+	if (!writeMergedSolutionDB(SOLUTION_DB_PATH, merged))
+	{
+		out << "[merge] The totals up to " << merged.lastTotal << " do not fit a solution database of this build, which ends at "
+			<< static_cast<int64>(MAX_TOTAL) << ", or " << SOLUTION_DB_PATH << " could not be written.\n";
+		return false;
+	}
 
-	return nextPossible[maxI];
+	out << "[merge] Wrote the totals up to " << merged.lastTotal << " from " << ranges.size() << " ranges to " << SOLUTION_DB_PATH << "\n";
+	return true;
+}
+
+/**
+ * Set by SIGINT or SIGTERM to stop the server of the `RUN_MODE_SERVE`
+ */
+static std::atomic<bool> stopServer(false);
+
+/**
+ * Handles SIGINT and SIGTERM in the `RUN_MODE_SERVE`
+ */
+static void handleStopSignal(int)
+{
+	stopServer.store(true);
 }
 
 /**
- * The main function. Iterates over every possible game and plays it. Depending on the `AUTOINPUT` definition above, the computer
- * can play with itself.
+ * Serves the solution database at `SOLUTION_DB_PATH` in the `RUN_MODE_SERVE` until SIGINT or SIGTERM and writes what it did to
+ * `out`. The database is loaded once, or solved up to `MAX_TOTAL` if it is missing, and every request reads it without a lock,
+ * see `runMoveServer`. Returns false if the period of the evaluations cannot be detected or the port could not be opened
  */
-int main()
+static bool runServeMode(const Options& options, std::ostream& out)
 {
-	file.open("./results.txt", std::ios::out);
+	Solver solver;
+	if (!solver.load(SOLUTION_DB_PATH))
+		solver.solve(MAX_TOTAL);
+
+	PeriodicSolution periodic;
+	if (!detectPeriod(periodic, 1000))
+	{
+		out << "[serve] Could not detect the period of the evaluations, larger totals cannot be answered.\n";
+		return false;
+	}
+
+	std::signal(SIGINT, handleStopSignal);
+	std::signal(SIGTERM, handleStopSignal);
+
+	out << "[serve] Serving the totals up to " << static_cast<int64>(solver.getMaxTotal())
+		<< " from the solution database and every larger one from its period on port " << options.port << std::endl;
+
+	if (!runMoveServer(solver, periodic, static_cast<uint16>(options.port), stopServer))
+	{
+		out << "[serve] Could not listen on port " << options.port << ".\n";
+		return false;
+	}
+
+	out << "[serve] Stopped.\n";
+	return true;
+}
+
+/**
+ * Returns whether the run selected by `options` searches with the transposition table, which is all `--warm-tt` applies to. The
+ * sweep only searches without the solution database, the Monte-Carlo games only for `POLICY_MINIMAX`, the other modes never
+ */
+static bool searchesWithTT(const Options& options)
+{
+	switch (options.mode)
+	{
+	case RUN_MODE_SELFPLAY:
+	case RUN_MODE_TABLE:
+	case RUN_MODE_INTERACTIVE:
+		return solutionDB.entries == nullptr;
+	case RUN_MODE_MONTECARLO:
+		return options.policies[0] == POLICY_MINIMAX || options.policies[1] == POLICY_MINIMAX;
+	default:
+		return false;
+	}
+}
+
+/**
+ * Saves the transposition table of the calling thread, together with the tables already merged into `savedTable`, to
+ * `TT_FILE_PATH` for the next run with `--warm-tt`
+ */
+static void saveWarmTT(TTSnapshot& savedTable, std::ostream& out)
+{
+	mergeTTSnapshot(savedTable);
+	if (!writeTTSnapshot(TT_FILE_PATH, savedTable))
+		out << "The transposition table could not be saved to " << TT_FILE_PATH << ".\n";
+}
+
+/**
+ * The main function. Iterates over every possible game and runs it as selected on the command line, see `printUsage`. Depending
+ * on the `DP_SOLVER` definition above, the evaluations are looked up from the solution database or computed by `miniMax`.
+ * Depending on the `PARALLEL_SWEEP` definition above, the games are run on multiple threads. Depending on the `VERIFY_TT`
+ * definition above, the search is verified first.
+ */
+int main(int argc, char** argv)
+{
+	Options options;
+	if (!parseOptions(argc, argv, options))
+	{
+		printUsage(std::cout, argv[0]);
+		return 1;
+	}
+
+	// 
+	// The sweep is checked again once the solution database is opened
+	// 
+
+	if (options.warmTT && !searchesWithTT(options))
+	{
+		std::cout << "Warning: --warm-tt is ignored, nothing in this run searches with the transposition table.\n";
+		options.warmTT = false;
+	}
+
+	if (options.mode == RUN_MODE_VARIANTS)
+	{
+		runVariantsMode(std::cout);
+		return 0;
+	}
+
+	if (options.mode == RUN_MODE_RANGE)
+		return runRangeMode(options, std::cout) ? 0 : 1;
+
+	if (options.mode == RUN_MODE_MERGE)
+		return runMergeMode(options, std::cout) ? 0 : 1;
+
+	if (options.mode == RUN_MODE_SERVE)
+		return runServeMode(options, std::cout) ? 0 : 1;
 
 	// 
 	// Transposition table initialization
 	// 
 
-	transpositionTable = reinterpret_cast<uint16*>(calloc(sizeof(uint16), NUM_GAME_STATES));
+	allocateTranspositionTable();
 
+#ifdef VERIFY_TT
 	// 
-	// Looping over every game possible
+	// Verifying the solvers and the batch search while every query is still searched
 	// 
 
-	for (int8 startTotal = 66; startTotal >= 11; startTotal--)
+	if (!verifyBatchOperations(100003, std::cout) || !verifyDPSolvers(MAX_TOTAL, std::cout) || !verifyBatchSearch(MAX_TOTAL, std::cout))
+		return 0;
+#endif // VERIFY_TT
+
+#ifdef DP_SOLVER
+	// 
+	// Solution database initialization
+	// 
+
+	if (!loadOrCreateSolutionDB(solutionDB, SOLUTION_DB_PATH, MAX_TOTAL))
+		std::cout << "The solution database is not available, falling back to minimax.\n";
+#endif // DP_SOLVER
+
+	// 
+	// Warming the transposition tables, the sweep only searches if the solution database is missing
+	// 
+
+	if (options.warmTT && !searchesWithTT(options))
 	{
+		std::cout << "Warning: --warm-tt is ignored, every game is looked up from the solution database without a search.\n";
+		options.warmTT = false;
+	}
+
+	TTSnapshot warmTable;
+	TTSnapshot savedTable;
+	if (options.warmTT)
+	{
+		if (readTTSnapshot(TT_FILE_PATH, warmTable))
+			applyTTSnapshot(warmTable);
+		else
+			std::cout << "The saved transposition table is not available, starting with an empty one.\n";
+	}
+
+	SearchStats sweepStats = {};
+	std::chrono::steady_clock::time_point sweepStart = std::chrono::steady_clock::now();
+
+	// 
+	// Collecting every game possible
+	// 
+
+	std::vector<GameState> startStates;
+	for (Total startTotal = 66; startTotal >= 11; startTotal--)
 		for (Move startMove = 1; startMove <= 6; startMove++)
-		{
 			for (Player startPlayer = -1; startPlayer <= -1; startPlayer += 2)
-			{
-				// 
-				// Game Initialization
-				//
+				startStates.push_back(createGameState(startMove, startPlayer, startTotal));
 
-				std::cout << "Starting total: " << std::to_string(startTotal) << std::endl;
-				std::cout << "Dice shows: " << std::to_string(startMove) << std::endl;
+	if (options.mode == RUN_MODE_MONTECARLO)
+	{
+		runMonteCarloMode(startStates, options, std::cout);
 
-				GameState curState = createGameState(startMove, startPlayer, startTotal);
+		if (options.warmTT)
+			saveWarmTT(savedTable, std::cout);
 
-				// 
-				// Computer flexes its abilites
-				// 
+		closeSolutionDB(solutionDB);
+		freeTranspositionTable();
+		return 0;
+	}
 
-				int8 eval = miniMax(curState, 100, -128, 127);
-				if (startPlayer == -1)
-					eval = -eval;
+#ifdef VERIFY_TT
+	// 
+	// Verifying the search before trusting it
+	// 
 
-				std::cout << "[" << std::to_string(eval) << "] The computer already knows " << (eval > 0 ? "it" : (eval < 0 ? "you" : "nobody")) << " will win if played perfectly." << std::endl;
-		
-				std::string str = "{dice:" + std::to_string(curState.lastMove) + ",startingplayer:" + std::to_string(curState.activePlayer) + ",total:" + std::to_string(curState.total) + ",eval:" + std::to_string(eval) + "}\n";
-				file << str;
+	if (!verifySearch(startStates, std::cout))
+		return 0;
+#endif // VERIFY_TT
 
-				if (startPlayer == 1)
-					std::cout << "Computer starts." << std::endl;
-				else
-					std::cout << "You start." << std::endl;
+	std::vector<SweepGame> games(startStates.size());
+	for (size_t i = 0; i < startStates.size(); i++)
+		games[i].startState = startStates[i];
 
-				// 
-				// Game starts
-				// 
+	// 
+	// Running every game, in parallel unless the user plays
+	// 
 
-				while (curState.winner == 0)
-				{
-					if (curState.activePlayer == 1)
-					{
-						// 
-						// Computer's turn
-						// 
-
-						curState = makeBestMove(curState);
-
-						std::cout << "[" << std::to_string(miniMax(curState, 63, -128, 127)) << "] The computer turns to " << std::to_string(curState.lastMove) << ".New total is " << std::to_string(curState.total) << std::endl;
-
-					}
-					else
-					{
-						// 
-						// Player's turn
-						// 
-
-						Move move = '?';
-
-#ifndef AUTOINPUT
-						std::cout << "Your move: ";
-						std::cin >> move;
-#endif // AUTOINPUT
-
-						if (move == '?')
-						{
-							// 
-							// Automatically make best move if player enters '?' or autoinput is active
-							// 
-
-							GameState bestState = makeBestMove(curState);
-
-							std::cout << "(You move " << std::to_string(bestState.lastMove) << ")" << std::endl;
-							move = bestState.lastMove;
-						}
-						else
-						{
-							// 
-							// Translate ASCII to move
-							// 
-
-							move -= '0';
-						}
-
-						// 
-						// Check move validity
-						// 
-
-						if (move + curState.lastMove == 7 || move == curState.lastMove)
-						{
-							std::cout << "## Your move is invalid ##" << std::endl;
-							continue;
-						}
-
-						// 
-						// Perform the move
-						// 
-
-						curState = performMove(curState, move);
-					}
-				}
+	size_t numGames;
+#ifdef PARALLEL_SWEEP
+	if (options.mode != RUN_MODE_INTERACTIVE)
+	{
+		unsigned numThreads = std::thread::hardware_concurrency();
+		sweepParallel(games, options, numThreads > 0 ? numThreads : 1, sweepStats, warmTable, options.warmTT ? &savedTable : nullptr);
+		numGames = games.size();
+	}
+	else
+	{
+		numGames = sweepSerial(games, options);
+		sweepStats = getSearchStats();
+	}
+#else
+	numGames = sweepSerial(games, options);
+	sweepStats = getSearchStats();
+#endif // PARALLEL_SWEEP
 
-				if (curState.winner == 1)
-				{
-					std::cout << "Computer wins." << std::endl;
-					if (eval < 1)
-						
-					{
-						std::cout << "huh?";
-						return 0;
-					}
-				}
-				else if (curState.winner == -1)
-				{
-					std::cout << "You win." << std::endl;
+	// 
+	// Writing the results in order, up to the first game that did not end as evaluated
+	// 
 
-					if (eval > -1)
-					{
-						std::cout << "huh?";
-						return 0;
-					}
-				}
+	beginResults(results, options.format, numGames);
 
-				//std::cout << "Minimax evaluates " << std::to_string(evaluation) << std::endl;
-			}
-		}
+	for (size_t i = 0; i < numGames; i++)
+	{
+		std::cout << games[i].log;
+
+		writeResult(results, games[i].startState, games[i].eval);
+
+		if (!games[i].consistent)
+			break;
 	}
 
-	file.close();
+#ifdef SEARCH_STATS
+	double sweepSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - sweepStart).count();
+	std::cout << "[stats] Sweep: " << formatSearchStats(sweepStats, sweepSeconds) << "\n";
+#else
+	(void)sweepStart;
+#endif // SEARCH_STATS
+
+	if (!flushResults(results, getResultsPath(options.format)))
+		std::cout << "The results could not be written to " << getResultsPath(options.format) << ".\n";
+
+	// 
+	// Saving the transposition tables for the next run, the table of the main thread holds the serial and the shared searches
+	// 
+
+	if (options.warmTT)
+		saveWarmTT(savedTable, std::cout);
+
+	closeSolutionDB(solutionDB);
+	freeTranspositionTable();
 	
 }
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "game.h"
+#include "iterativesearch.h"
+#include "minimax.h"
+#include <chrono>
+
+/**
+ * The number of nodes an anytime search visits between two checks of its budget
+ */
+static constexpr uint64 ANYTIME_SLICE_NODES = 128;
+
+/**
+ * The limits of an anytime search. A limit of zero is no limit, so a budget of zeros searches until the result is proven
+ */
+typedef struct _SearchBudget {
+	std::chrono::nanoseconds maxTime;
+	uint64 maxNodes;
+} SearchBudget;
+
+/**
+ * The result of an anytime search. `depth` is the deepest iteration that was completed and `eval` the evaluation of `bestMove` at
+ * that depth. `exact` tells whether the evaluation is proven, evaluations of 1 and -1 always are
+ */
+typedef struct _AnytimeResult {
+	Move bestMove;
+	int8 eval;
+	uint8 depth;
+	bool exact;
+	uint64 nodes;
+} AnytimeResult;
+
+/**
+ * Checks whether an anytime search that has visited `nodes` nodes used up its `budget`, which ends at `deadline`
+ */
+static inline bool isBudgetUsedUp(const SearchBudget& budget, const std::chrono::steady_clock::time_point& deadline, const uint64& nodes)
+{
+	return (budget.maxNodes != 0 && nodes >= budget.maxNodes)
+		|| (budget.maxTime.count() != 0 && std::chrono::steady_clock::now() >= deadline);
+}
+
+/**
+ * Searches the best move of `curState` by iterative deepening within `budget`. Every iteration searches each possible next state
+ * one move deeper with `miniMaxIterative` in slices of `ANYTIME_SLICE_NODES` nodes, so the search can stop in the middle of any
+ * iteration once the budget is used up. The result of the last completed iteration is returned then. The search stops early once
+ * its result is proven, which includes the first proven win. The first iteration only looks at the possible next states and is
+ * always completed, so there is always a legal move. Won and lost states stay in the transposition table of the calling thread
+ * with `PROVEN_DEPTH`, so later iterations and later searches do not search them again. The game must not be over yet
+ */
+static AnytimeResult searchBestMove(const GameState& curState, const SearchBudget& budget, const uint8& maxDepth = 100)
+{
+	static thread_local IterativeSearch search;
+
+	std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + budget.maxTime;
+
+	GameState nextPossible[4];
+	getPossibleStates(nextPossible, curState);
+
+	AnytimeResult result = {nextPossible[0].lastMove, MIN_EVAL, 0, false, 0};
+
+	// 
+	// The counter is wider than the depth, so a `maxDepth` of 255 ends as well
+	// 
+
+	for (unsigned depth = 1; depth <= maxDepth; depth++)
+	{
+		int8 max = MIN_EVAL - 1;
+		Move bestMove = 0;
+		bool exact = true;
+		bool stopped = false;
+
+		for (uint8 i = 0; i < 4 && !stopped; i++)
+		{
+			// 
+			// Search the next state in slices until it is done or the budget is used up
+			// 
+
+			beginIterativeSearch(search, nextPossible[i], static_cast<uint8>(depth - 1), -128, 127);
+			while (!continueIterativeSearch(search, ANYTIME_SLICE_NODES))
+			{
+				stopped = depth > 1 && isBudgetUsedUp(budget, deadline, result.nodes + search.nodes);
+				if (stopped)
+					break;
+			}
+			result.nodes += search.nodes;
+
+			if (stopped)
+				break;
+
+			int8 val = -search.result;
+			if (val >= max)
+			{
+				max = val;
+				bestMove = nextPossible[i].lastMove;
+			}
+
+			if (val != MIN_EVAL && val != MAX_EVAL)
+				exact = false;
+
+			// 
+			// A proven win cannot be improved on
+			// 
+
+			if (val == MAX_EVAL)
+			{
+				exact = true;
+				break;
+			}
+
+			stopped = depth > 1 && i < 3 && isBudgetUsedUp(budget, deadline, result.nodes);
+		}
+
+		if (stopped)
+			break;
+
+		result.bestMove = bestMove;
+		result.eval = max;
+		result.depth = static_cast<uint8>(depth);
+		result.exact = exact;
+
+		if (exact || isBudgetUsedUp(budget, deadline, result.nodes))
+			break;
+	}
+
+	return result;
+}
+
+/**
+ * Chooses the best move within `budget` and performs it, just like `makeBestMove`. The move is looked up from the solution
+ * database if it covers the state, otherwise it is searched by `searchBestMove`
+ */
+static inline GameState makeBestMoveWithin(const GameState& curState, const SearchBudget& budget)
+{
+	COUNT_STAT(bestMoveCalls);
+
+	if (isInSolutionDB(solutionDB, curState))
+	{
+		COUNT_STAT(bestMoveLookups);
+		return performMove(curState, getDBMove(getDBEntry(solutionDB, curState)));
+	}
+
+	return performMove(curState, searchBestMove(curState, budget).bestMove);
+}
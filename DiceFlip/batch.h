@@ -0,0 +1,224 @@
+#pragma once
+
+#include "game.h"
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+
+/**
+ * Vectorized versions of `performMove`, `eval` and `getPossibleStates` working on whole arrays of GameStates, and the layer
+ * expansion of `solveDP` and `extendDP` built on them. With 8 bit totals a
+ * GameState is a 4 byte POD in the form
+ * WWWWWWWWPPPPPPPPMMMMMMMMTTTTTTTT (little endian), where
+ * T is the total,
+ * M is the last move,
+ * P is the active player and
+ * W is the winner
+ * so four of them fit into one SSE2 register. Other total widths and targets without SSE2 use the scalar functions.
+ */
+#if TOTAL_BITS == 8 && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define BATCH_SSE2
+#include <emmintrin.h>
+#endif // TOTAL_BITS == 8 && SSE2
+
+#ifdef BATCH_SSE2
+static_assert(sizeof(GameState) == 4 && offsetof(GameState, total) == 0 && offsetof(GameState, lastMove) == 1
+	&& offsetof(GameState, activePlayer) == 2 && offsetof(GameState, winner) == 3, "Unexpected GameState layout");
+
+/**
+ * Performs `performMove` on four GameStates at once. Every 32 bit lane of `moves` holds the move of the corresponding state in its
+ * lowest byte, all other bytes must be zero
+ */
+static inline __m128i performMove4(const __m128i& states, const __m128i& moves) noexcept
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i totalMask = _mm_set1_epi32(0x000000FF);
+	const __m128i playerMask = _mm_set1_epi32(0x00FF0000);
+	const __m128i winnerMask = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+	__m128i total = _mm_and_si128(_mm_sub_epi8(states, moves), totalMask);
+	__m128i player = _mm_and_si128(_mm_sub_epi8(zero, states), playerMask);
+
+	// 
+	// The next player wins if the total drops to zero or below
+	// 
+
+	__m128i notOver = _mm_slli_epi32(_mm_cmpgt_epi8(total, zero), 24);
+	__m128i winner = _mm_andnot_si128(notOver, _mm_and_si128(_mm_slli_epi32(player, 8), winnerMask));
+
+	return _mm_or_si128(_mm_or_si128(total, _mm_slli_epi32(moves, 8)), _mm_or_si128(player, winner));
+}
+
+/**
+ * Packs a GameState into a 32 bit lane as expected by `performMove4`. The lane is assembled from the members rather than copied,
+ * so states that were just written member by member do not have to be read back as a whole
+ */
+static inline int32 packGameState(const GameState& state) noexcept
+{
+	return static_cast<int32>(static_cast<uint32>(static_cast<uint8>(state.total)) | static_cast<uint32>(state.lastMove) << 8
+		| static_cast<uint32>(static_cast<uint8>(state.activePlayer)) << 16 | static_cast<uint32>(static_cast<uint8>(state.winner)) << 24);
+}
+
+/**
+ * Widens four moves to the lowest bytes of four 32 bit lanes as expected by `performMove4`
+ */
+static inline __m128i widenMoves4(const Move* moves) noexcept
+{
+	int32 packed;
+	memcpy(&packed, moves, sizeof(packed));
+
+	const __m128i zero = _mm_setzero_si128();
+	return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+}
+#endif // BATCH_SSE2
+
+/**
+ * Performs `moves[i]` on `states[i]` for every i < `count` and writes the results to `out`
+ */
+static inline void performMoveBatch(GameState* out, const GameState* states, const Move* moves, const size_t& count) noexcept
+{
+	size_t i = 0;
+
+#ifdef BATCH_SSE2
+	const size_t blocks = count - count % 4;
+	for (; i < blocks; i += 4)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(states + i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), performMove4(block, widenMoves4(moves + i)));
+	}
+#endif // BATCH_SSE2
+
+	for (; i < count; i++)
+		out[i] = performMove(states[i], moves[i]);
+}
+
+/**
+ * Evaluates `states[i]` like `eval` for every i < `count` and writes the results to `out`
+ */
+static inline void evalBatch(int8* out, const GameState* states, const size_t& count) noexcept
+{
+	size_t i = 0;
+
+#ifdef BATCH_SSE2
+	const __m128i zero = _mm_setzero_si128();
+	const size_t blocks = count - count % 4;
+
+	for (; i < blocks; i += 4)
+	{
+		__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(states + i));
+
+		// 
+		// Keep the winner of every state whose total is zero or below and narrow it to a byte
+		// 
+
+		__m128i notOver = _mm_slli_epi32(_mm_cmpgt_epi8(block, zero), 24);
+		__m128i winner = _mm_srai_epi32(_mm_andnot_si128(notOver, block), 24);
+		__m128i packed = _mm_packs_epi16(_mm_packs_epi32(winner, zero), zero);
+
+		int32 result = _mm_cvtsi128_si32(packed);
+		memcpy(out + i, &result, sizeof(result));
+	}
+#endif // BATCH_SSE2
+
+	for (; i < count; i++)
+		out[i] = eval(states[i]);
+}
+
+/**
+ * Expands a frontier of GameStates by writing the four successors of `states[i]` to `out[4 * i]`, ..., `out[4 * i + 3]` for every
+ * i < `count`, in the order of `getPossibleStates`. `out` must hold 4 * `count` states
+ */
+static inline void getPossibleStatesBatch(GameState* out, const GameState* states, const size_t& count) noexcept
+{
+#ifdef BATCH_SSE2
+	for (size_t i = 0; i < count; i++)
+	{
+		__m128i block = _mm_set1_epi32(packGameState(states[i]));
+		__m128i moves = widenMoves4(MOVE_TABLE.moves[states[i].lastMove]);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * i), performMove4(block, moves));
+	}
+#else
+	for (size_t i = 0; i < count; i++)
+		getPossibleStates(out + 4 * i, states[i]);
+#endif // BATCH_SSE2
+}
+
+/**
+ * The face pairs of the four successors of every dice face, in the order of `MOVE_TABLE`, generated at compile time. Row 0 does
+ * not correspond to a dice face and is left empty
+ */
+typedef struct _SuccessorPairs {
+	uint32 pairs[7][4];
+
+	constexpr _SuccessorPairs() : pairs{}
+	{
+		for (Move face = 1; face <= 6; face++)
+			for (uint8 i = 0; i < 4; i++)
+				pairs[face][i] = FACE_PAIRS[MOVE_TABLE.moves[face][i]];
+	}
+} SuccessorPairs;
+
+/**
+ * The successor face pairs used by `getSuccessorIndicesBatch`
+ */
+static constexpr SuccessorPairs SUCCESSOR_PAIRS = SuccessorPairs();
+
+/**
+ * Expands a frontier of GameStates into the canonical indices of their successors by writing `canonicalIndex` of the four
+ * successors of `states[i]` to `out[4 * i]`, ..., `out[4 * i + 3]` for every i < `count`, in the order of `getPossibleStates`.
+ * `out` must hold 4 * `count` indices
+ */
+static inline void getSuccessorIndicesBatch(uint32* out, const GameState* states, const size_t& count) noexcept
+{
+#ifdef BATCH_SSE2
+	const __m128i minTotal = _mm_set1_epi32(MIN_TOTAL);
+	const __m128i numPairs = _mm_set1_epi32(NUM_FACE_PAIRS);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		const Move face = states[i].lastMove;
+		__m128i successors = performMove4(_mm_set1_epi32(packGameState(states[i])), widenMoves4(MOVE_TABLE.moves[face]));
+
+		// 
+		// Sign extend the totals to 32 bits. Every index is below 2^16, so a 16 bit multiplication is enough
+		// 
+
+		__m128i totals = _mm_sub_epi32(_mm_srai_epi32(_mm_slli_epi32(successors, 24), 24), minTotal);
+		__m128i pairs = _mm_loadu_si128(reinterpret_cast<const __m128i*>(SUCCESSOR_PAIRS.pairs[face]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * i), _mm_add_epi32(_mm_mullo_epi16(totals, numPairs), pairs));
+	}
+#else
+	for (size_t i = 0; i < count; i++)
+	{
+		GameState successors[4];
+		getPossibleStates(successors, states[i]);
+		for (uint8 j = 0; j < 4; j++)
+			out[4 * i + j] = canonicalIndex(successors[j]);
+	}
+#endif // BATCH_SSE2
+}
+
+#ifdef BATCH_SSE2
+static_assert(NUM_CANONICAL_STATES <= 65536, "The canonical indices of getSuccessorIndicesBatch must fit 16 bits");
+#endif // BATCH_SSE2
+
+/**
+ * Solves the states of `total` into a table filled by `solveDP` up to `total - 1`, as one layer of a breadth-first expansion. The
+ * state of every face pair is expanded into the canonical indices of its successors by `getSuccessorIndicesBatch` and their
+ * values are read from the layers below. Successors that end the game are read from the base cases of the table, which must be
+ * solved, so no `eval` is needed. This is the recurrence of `solveVariantTotals` for `StandardRules` on whole GameStates. `total`
+ * must be at least 1
+ */
+static inline void solveDPLayer(int8* values, const Total& total) noexcept
+{
+	for (Move face = 1; face <= 3; face++)
+	{
+		const GameState state = createGameState(face, 1, total);
+		uint32 successors[4];
+		getSuccessorIndicesBatch(successors, &state, 1);
+
+		int8 first = static_cast<int8>(std::max(-values[successors[0]], -values[successors[1]]));
+		int8 second = static_cast<int8>(std::max(-values[successors[2]], -values[successors[3]]));
+		values[canonicalIndex(state)] = std::max(first, second);
+	}
+}
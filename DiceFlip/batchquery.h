@@ -0,0 +1,160 @@
+#pragma once
+
+#include "game.h"
+#include "transposition.h"
+#include "minimax.h"
+#include "solutiondb.h"
+#include "solver.h"
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+/**
+ * Answers a single query of `searchBatch`. The state is looked up from the solution database if it covers the state, otherwise
+ * every possible next state is searched by `searchState`, just like in `makeBestMove`
+ */
+static QueryResult searchQuery(const GameState& state)
+{
+	if (isInSolutionDB(solutionDB, state))
+	{
+		uint8 entry = getDBEntry(solutionDB, state);
+		return QueryResult{getDBEval(entry), getDBMove(entry)};
+	}
+
+	// 
+	// The opponent moved the total to zero or below and lost, see `solveDP`
+	// 
+
+	if (state.total <= 0)
+		return QueryResult{MAX_EVAL, 0};
+
+	GameState nextPossible[4];
+	getPossibleStates(nextPossible, state);
+
+	QueryResult result = {MIN_EVAL - 1, 0};
+	for (uint8 i = 0; i < 4; i++)
+	{
+		int8 evaluation = -searchState(nextPossible[i], 100, -128, 127);
+		if (evaluation >= result.eval)
+		{
+			result.eval = evaluation;
+			result.bestMove = nextPossible[i].lastMove;
+		}
+	}
+
+	return result;
+}
+
+/**
+ * Proves every state of `total` in the transposition table of the calling thread by `searchState`. Every state of the totals
+ * below must already be proven, so each search ends at the next move. The game always ends with a winner, so every searched
+ * value is a win or a loss and stored with `PROVEN_DEPTH`
+ */
+static void proveTotal(const Total& total)
+{
+	for (Move lastMove = 1; lastMove <= 3; lastMove++)
+		searchState(createGameState(lastMove, 1, total), 100, -128, 127);
+}
+
+/**
+ * Writes the positions of the `count` queries of `states` to `order`, sorted by their totals. Batches covering few totals are
+ * sorted by counting, others by `std::sort`. The sort is stable, so queries of the same total keep their order
+ */
+static void sortQueriesByTotal(const GameState* states, const size_t& count, std::vector<uint32>& order)
+{
+	order.resize(count);
+	if (count == 0)
+		return;
+
+	int64 minTotal = states[0].total;
+	int64 maxTotal = states[0].total;
+	for (size_t i = 1; i < count; i++)
+	{
+		minTotal = std::min<int64>(minTotal, states[i].total);
+		maxTotal = std::max<int64>(maxTotal, states[i].total);
+	}
+
+	size_t range = static_cast<size_t>(maxTotal - minTotal + 1);
+	if (range <= 2 * count + 1024)
+	{
+		std::vector<uint32> starts(range + 1, 0);
+		for (size_t i = 0; i < count; i++)
+			starts[states[i].total - minTotal + 1]++;
+
+		for (size_t total = 1; total <= range; total++)
+			starts[total] += starts[total - 1];
+
+		for (size_t i = 0; i < count; i++)
+			order[starts[states[i].total - minTotal]++] = static_cast<uint32>(i);
+		return;
+	}
+
+	std::vector<uint64> keys(count);
+	for (size_t i = 0; i < count; i++)
+		keys[i] = (static_cast<uint64>(states[i].total - minTotal) << 32) | i;
+	std::sort(keys.begin(), keys.end());
+
+	for (size_t i = 0; i < count; i++)
+		order[i] = static_cast<uint32>(keys[i]);
+}
+
+/**
+ * Answers the queries `order[begin]` to `order[end - 1]` of `searchBatch`, which are sorted by their totals, on the calling
+ * thread. Before a state beyond the solution database is searched, every total below it is proven by `proveTotal`, bottom-up like
+ * `solveDP`, so each search only looks one move ahead and its answer is exact. The transposition table of the calling thread must
+ * be allocated
+ */
+static void searchSortedQueries(const GameState* states, const uint32* order, const size_t& begin, const size_t& end,
+	QueryResult* results)
+{
+	int64 provenTotal = 0;
+	for (size_t i = begin; i < end; i++)
+	{
+		const GameState& state = states[order[i]];
+		if (!isInSolutionDB(solutionDB, state))
+			while (provenTotal < state.total - 1)
+				proveTotal(static_cast<Total>(++provenTotal));
+
+		results[order[i]] = searchQuery(state);
+	}
+}
+
+/**
+ * Answers `count` queries at once like `Solver::queryBatch`, but states beyond the solution database are searched instead of
+ * being left unanswered, see `searchSortedQueries`. The queries are grouped by their totals, lowest first, so every proven total
+ * serves all queries above it. A batch reaching the total `n` costs about `3n` searches of one move for the proofs. Large batches
+ * are split into contiguous ranges of the sorted queries that are answered on up to `numThreads` threads, the calling thread
+ * included. Like in the sweep, every other thread allocates its own transposition table, or they all share the one of
+ * `SHARED_TT`, and proves the totals below its own range. The calling thread's table must be allocated. `count` must be less
+ * than 2^32
+ */
+static void searchBatch(const GameState* states, const size_t& count, QueryResult* results, const unsigned& numThreads = 1)
+{
+	std::vector<uint32> order;
+	sortQueriesByTotal(states, count, order);
+
+	size_t threads = std::max<size_t>(1, std::min<size_t>(numThreads, count / MIN_QUERIES_PER_THREAD));
+	size_t chunk = (count + threads - 1) / threads;
+
+	std::vector<std::thread> workers;
+	for (size_t t = 1; t < threads; t++)
+	{
+		workers.emplace_back([states, &order, results, t, chunk, count]()
+		{
+#ifndef SHARED_TT
+			allocateTranspositionTable();
+#endif // SHARED_TT
+
+			searchSortedQueries(states, order.data(), t * chunk, std::min(count, (t + 1) * chunk), results);
+
+#ifndef SHARED_TT
+			freeTranspositionTable();
+#endif // SHARED_TT
+		});
+	}
+
+	searchSortedQueries(states, order.data(), 0, std::min(count, chunk), results);
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "types.h"
+#include <stddef.h>
+
+/**
+ * The initial value of a 64 bit FNV-1a hash
+ */
+static constexpr uint64 FNV1A_OFFSET_BASIS = 0xCBF29CE484222325ull;
+
+/**
+ * Continues the 64 bit FNV-1a hash `hash` with `size` bytes of `data`. Used as the checksum of the files written by DiceFlip
+ */
+static inline uint64 hashFNV1a(uint64 hash, const void* data, const size_t& size) noexcept
+{
+	const uint8* bytes = reinterpret_cast<const uint8*>(data);
+	for (size_t i = 0; i < size; i++)
+		hash = (hash ^ bytes[i]) * 0x100000001B3ull;
+
+	return hash;
+}
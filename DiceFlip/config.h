@@ -0,0 +1,68 @@
+#pragma once
+
+/**
+ * Compile-time switches of the solver. Unlike the switches in `DiceFlip.cpp`, these change the headers and therefore apply to
+ * every program built from them.
+ */
+
+/**
+ * If defined, all threads share one lock-free transposition table instead of owning one each. See `transpositionTable`
+ */
+//#define SHARED_TT
+
+/**
+ * If defined, the transposition table is allocated lazily in segments of `TT_SEGMENT_BYTES`, each on the first store into it.
+ * The canonical index is ordered by total, so every segment holds the states of a range of totals and searches only allocate
+ * the totals they reach. See `transpositionTable`
+ */
+//#define SEGMENTED_TT
+
+/**
+ * If defined, the memory of the transposition table is backed by huge pages where the OS allows it, see `allocateTTMemory`.
+ * Segments of a `SEGMENTED_TT` grow to a huge page each
+ */
+//#define HUGE_PAGE_TT
+
+/**
+ * If defined, the transposition table is a bounded table of `TT_SIZE_MB` megabytes in cache line sized buckets instead of having
+ * one entry per canonical index. Entries carry their canonical index as a key and are replaced by depth, see `TTBucket`. Cannot be
+ * combined with `SEGMENTED_TT`
+ */
+//#define BUCKET_TT
+
+/**
+ * The size of a `BUCKET_TT` in megabytes. Tables that would be larger than needed for every canonical index are cut down
+ */
+#ifndef TT_SIZE_MB
+#define TT_SIZE_MB 64
+#endif // TT_SIZE_MB
+
+/**
+ * The number of bits of `GameState::total`, either 8, 16 or 32. 8 bit totals keep the GameState at 4 bytes, wider totals allow
+ * games with larger starting totals
+ */
+#ifndef TOTAL_BITS
+#define TOTAL_BITS 8
+#endif // TOTAL_BITS
+
+/**
+ * The largest total the tables are sized for. If not defined, `MAX_TOTAL` is derived from `TOTAL_BITS`
+ */
+//#define TOTAL_LIMIT 4095
+
+/**
+ * If defined, `miniMax` and `makeBestMove` count their nodes, transposition table accesses and cutoffs in `searchStats`. If not
+ * defined, the counters compile to nothing
+ */
+//#define SEARCH_STATS
+
+/**
+ * If defined, `evaluateState` and `makeBestMove` search with the non-recursive `miniMaxIterative` instead of `miniMax`
+ */
+//#define ITERATIVE_SEARCH
+
+/**
+ * If defined, `evaluateState` and `makeBestMove` search with the move ordering principal variation search `miniMaxPVS` instead of
+ * `miniMax`. Takes precedence over `ITERATIVE_SEARCH`
+ */
+//#define PV_SEARCH
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "game.h"
+#include "checksum.h"
+#include "rules.h"
+#include "variantsolver.h"
+#include "solutiondb.h"
+#include <algorithm>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+/**
+ * Magic number at the start of every range file. Reads "DFRG" in a little endian file
+ */
+static constexpr uint32 RANGE_FILE_MAGIC = 0x47524644;
+
+/**
+ * Version of the range file format. Must be increased whenever the layout of the header or of `VariantRange::values` changes
+ */
+static constexpr uint32 RANGE_FILE_VERSION = 1;
+
+/**
+ * The header of a range file, which stores a `VariantRange`. It is followed by the values of the range. `rulesHash` is the
+ * FNV-1a hash of the name of the rules, so ranges of different variants are never mixed up. `checksum` is the FNV-1a hash of the
+ * header, with a zero checksum, and the values
+ */
+typedef struct _RangeFileHeader {
+	uint32 magic;
+	uint32 version;
+	uint64 rulesHash;
+	int64 firstTotal;
+	int64 lastTotal;
+	uint8 faces;
+	uint8 numClasses;
+	uint8 reserved[6];
+	uint64 checksum;
+} RangeFileHeader;
+
+static_assert(sizeof(RangeFileHeader) == 48, "RangeFileHeader must not contain padding, it is hashed as a whole");
+
+/**
+ * Returns the hash identifying `Rules` in range files
+ */
+template<typename Rules>
+static uint64 getRulesHash()
+{
+	const std::string name = Rules::getName();
+	return hashFNV1a(FNV1A_OFFSET_BASIS, name.data(), name.size());
+}
+
+/**
+ * Returns the path of the range file written by solving {firstTotal, ..., lastTotal}
+ */
+static std::string getRangePath(const int64& firstTotal, const int64& lastTotal)
+{
+	return "./range_" + std::to_string(firstTotal) + "_" + std::to_string(lastTotal) + ".dfr";
+}
+
+/**
+ * Returns the path of the boundary file the range starting at `firstTotal` reads, see `getRangeBoundary`
+ */
+static std::string getBoundaryPath(const int64& firstTotal)
+{
+	return "./boundary_" + std::to_string(firstTotal) + ".dfr";
+}
+
+/**
+ * Writes the number of bytes from the current position of `file` to its end to `size`, without moving the position. Returns
+ * false if the size could not be determined
+ */
+static bool getRemainingFileSize(FILE* file, uint64& size)
+{
+#ifdef _WIN32
+	const int64 position = _ftelli64(file);
+	if (position < 0 || _fseeki64(file, 0, SEEK_END) != 0)
+		return false;
+
+	const int64 end = _ftelli64(file);
+	if (end < position || _fseeki64(file, position, SEEK_SET) != 0)
+		return false;
+#else
+	const off_t position = ftello(file);
+	if (position < 0 || fseeko(file, 0, SEEK_END) != 0)
+		return false;
+
+	const off_t end = ftello(file);
+	if (end < position || fseeko(file, position, SEEK_SET) != 0)
+		return false;
+#endif // _WIN32
+
+	size = static_cast<uint64>(end - position);
+	return true;
+}
+
+/**
+ * Writes `range` of a variant of `Rules` to `path`. Returns false if the file could not be written
+ */
+template<typename Rules>
+static bool writeVariantRange(const char* path, const VariantRange& range)
+{
+	RangeFileHeader header = {RANGE_FILE_MAGIC, RANGE_FILE_VERSION, getRulesHash<Rules>(), range.firstTotal, range.lastTotal,
+		Rules::FACES, RuleTablesOf<Rules>::VALUE.numClasses, {0, 0, 0, 0, 0, 0}, 0};
+	header.checksum = hashFNV1a(hashFNV1a(FNV1A_OFFSET_BASIS, &header, sizeof(header)), range.values.data(), range.values.size());
+
+	FILE* out = fopen(path, "wb");
+	if (out == nullptr)
+		return false;
+
+	bool success = fwrite(&header, sizeof(header), 1, out) == 1
+		&& fwrite(range.values.data(), sizeof(int8), range.values.size(), out) == range.values.size();
+
+	return fclose(out) == 0 && success;
+}
+
+/**
+ * Reads a range of a variant of `Rules` written by `writeVariantRange` from `path` into `range`. Returns false if the file does not
+ * exist, belongs to other rules, does not match the current format, does not hold exactly the totals of its header or fails its
+ * checksum, in which case `range` is left untouched
+ */
+template<typename Rules>
+static bool readVariantRange(const char* path, VariantRange& range)
+{
+	FILE* in = fopen(path, "rb");
+	if (in == nullptr)
+		return false;
+
+	RangeFileHeader header;
+	uint64 remaining;
+	if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != RANGE_FILE_MAGIC || header.version != RANGE_FILE_VERSION
+		|| header.rulesHash != getRulesHash<Rules>() || header.faces != Rules::FACES
+		|| header.numClasses != RuleTablesOf<Rules>::VALUE.numClasses || header.firstTotal < getVariantMinTotal<Rules>()
+		|| header.lastTotal < header.firstTotal || !getRemainingFileSize(in, remaining))
+	{
+		fclose(in);
+		return false;
+	}
+
+	// 
+	// The values must fill the rest of the file exactly, checked before anything is allocated for a corrupt header
+	// 
+
+	const uint64 span = static_cast<uint64>(header.lastTotal) - static_cast<uint64>(header.firstTotal);
+	if (span >= remaining / header.numClasses || (span + 1) * header.numClasses != remaining)
+	{
+		fclose(in);
+		return false;
+	}
+
+	std::vector<int8> values(static_cast<size_t>(remaining));
+	bool success = fread(values.data(), sizeof(int8), values.size(), in) == values.size();
+	fclose(in);
+
+	uint64 checksum = header.checksum;
+	header.checksum = 0;
+	if (!success || hashFNV1a(hashFNV1a(FNV1A_OFFSET_BASIS, &header, sizeof(header)), values.data(), values.size()) != checksum)
+		return false;
+
+	range.firstTotal = header.firstTotal;
+	range.lastTotal = header.lastTotal;
+	range.values.swap(values);
+	return true;
+}
+
+/**
+ * Merges the `ranges` of a variant, solved one after another by `solveRangeNode`, into one range starting at `getVariantMinTotal()`, so `merged`
+ * holds the table of `solveVariant`. The ranges may come in any order and may overlap, but together they must cover every total
+ * from 1 up to the largest one without a gap, and overlapping totals must agree. Missing totals of zero and below are base cases
+ * and filled in. Returns false if the ranges do not fit together
+ */
+template<typename Rules>
+static bool mergeVariantRanges(VariantRange& merged, const std::vector<VariantRange>& ranges)
+{
+	const int64 minTotal = getVariantMinTotal<Rules>();
+	const RuleTables<Rules>& tables = RuleTablesOf<Rules>::VALUE;
+
+	int64 lastTotal = 0;
+	for (const VariantRange& range : ranges)
+		if (range.lastTotal > lastTotal)
+			lastTotal = range.lastTotal;
+
+	// 
+	// Every total is written by the first range covering it, later ones must agree. Unsolved values are zero
+	// 
+
+	VariantRange result;
+	result.firstTotal = minTotal;
+	result.lastTotal = lastTotal;
+	result.values.assign(static_cast<size_t>(lastTotal - minTotal + 1) * tables.numClasses, 0);
+
+	for (const VariantRange& range : ranges)
+	{
+		for (int64 total = range.firstTotal; total <= range.lastTotal; total++)
+		{
+			for (uint8 face = 1; face <= Rules::FACES; face++)
+			{
+				int8& value = result.values[static_cast<size_t>(total - minTotal) * tables.numClasses + tables.faceClasses[face]];
+				int8 solved = getRangeValue<Rules>(range, total, face);
+				if (value != 0 && value != solved)
+					return false;
+				value = solved;
+			}
+		}
+	}
+
+	for (int64 total = minTotal; total <= lastTotal; total++)
+	{
+		for (uint8 face = 1; face <= Rules::FACES; face++)
+		{
+			int8& value = result.values[static_cast<size_t>(total - minTotal) * tables.numClasses + tables.faceClasses[face]];
+			if (value != 0)
+				continue;
+
+			if (total > 0)
+				return false;
+			value = getVariantBaseValue<Rules>(total);
+		}
+	}
+
+	merged.firstTotal = result.firstTotal;
+	merged.lastTotal = result.lastTotal;
+	merged.values.swap(result.values);
+	return true;
+}
+
+/**
+ * Writes a solution database for DiceFlip from a range merged by `mergeVariantRanges`, which must not go beyond `MAX_TOTAL`.
+ * The values of `StandardRules` are laid out like `canonicalIndex`, so the database is built from them just like from those of
+ * `solveDP`. Returns false if the range does not fit the database or the file could not be written
+ */
+static bool writeMergedSolutionDB(const char* path, const VariantRange& merged)
+{
+	if (merged.firstTotal != MIN_TOTAL || merged.lastTotal > MAX_TOTAL || merged.lastTotal < MIN_TOTAL)
+		return false;
+
+	std::vector<int8> values(NUM_CANONICAL_STATES, 0);
+	std::copy(merged.values.begin(), merged.values.end(), values.begin());
+
+	std::vector<uint8> entries(NUM_CANONICAL_STATES, 0);
+	buildSolutionEntries(entries.data(), values.data(), static_cast<Total>(merged.lastTotal));
+	return writeSolutionEntries(path, entries.data(), static_cast<Total>(merged.lastTotal));
+}
+
+/**
+ * Solves the totals {firstTotal, ..., lastTotal} as one step of a solve split into ranges. The boundary of the range below is read
+ * from `getBoundaryPath(firstTotal)` unless the range starts at a total of 1 or below. The solved range is written to
+ * `getRangePath(firstTotal, lastTotal)` and its boundary to `getBoundaryPath(lastTotal + 1)`, which is all the next range needs,
+ * even if this range is shorter than `Rules::FACES` totals. Every range depends on the boundary of the one below, so the ranges
+ * are solved one after another, possibly on different machines that pass the boundary files on. This only splits the memory
+ * and the files of the solve, not its runtime. Returns false if the boundary is missing or a file could not be written
+ */
+template<typename Rules>
+static bool solveRangeNode(const int64& firstTotal, const int64& lastTotal)
+{
+	VariantRange boundary;
+	if (firstTotal > 1 && !readVariantRange<Rules>(getBoundaryPath(firstTotal).c_str(), boundary))
+		return false;
+
+	VariantRange range;
+	if (!solveVariantRange<Rules>(range, &boundary, firstTotal, lastTotal))
+		return false;
+
+	VariantRange nextBoundary;
+	getRangeBoundary<Rules>(nextBoundary, range, &boundary);
+
+	return writeVariantRange<Rules>(getRangePath(firstTotal, lastTotal).c_str(), range)
+		&& writeVariantRange<Rules>(getBoundaryPath(lastTotal + 1).c_str(), nextBoundary);
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "game.h"
+#include "batch.h"
+#include "variantsolver.h"
+
+/**
+ * Extends a table filled by `solveDP` up to `solvedTotal` to every total up to `maxTotal`. Only the totals in
+ * {solvedTotal + 1, ..., maxTotal} are visited, every move lowers the total by at most 6, so their successors are either solved
+ * before or already in the table. A `solvedTotal` below `MIN_TOTAL` solves the whole table. The table is laid out like
+ * `variantIndex` of `StandardRules`. The base cases of totals of zero and below are written by `solveVariantTotals` of
+ * `StandardRules`, every total above is expanded as one layer of GameStates by `solveDPLayer`
+ */
+static void extendDP(int8* values, const int64& solvedTotal, const Total& maxTotal)
+{
+	const int64 firstTotal = solvedTotal < MIN_TOTAL ? MIN_TOTAL : solvedTotal + 1;
+	if (firstTotal > maxTotal)
+		return;
+
+	if (firstTotal <= 0)
+	{
+		solveVariantTotals<StandardRules>(values + variantIndex<StandardRules>(firstTotal, 1), firstTotal, 0,
+			[](const int64&, const uint8&)
+			{
+				return static_cast<int8>(0);
+			});
+	}
+
+	for (int64 total = firstTotal > 1 ? firstTotal : 1; total <= maxTotal; total++)
+		solveDPLayer(values, static_cast<Total>(total));
+}
+
+/**
+ * Solves every GameState with a total in {MIN_TOTAL, ..., maxTotal} bottom-up. Every move lowers the total, so the successors
+ * of a state always have a smaller total and are already solved when the state itself is visited. This makes the runtime
+ * linear in the number of states, without any recursion or pruning.
+ * `values` must hold `NUM_CANONICAL_STATES` entries and is indexed by `canonicalIndex`. Like the return value of `miniMax`, every
+ * value is given from the point of view of the state's active player, so only one state per canonical index is solved.
+ */
+static void solveDP(int8* values, const Total& maxTotal)
+{
+	extendDP(values, MIN_TOTAL - 1, maxTotal);
+}
+
+/**
+ * Returns the value of the given `GameState` from a table filled by `solveDP`
+ */
+static inline int8 getDPValue(const int8* values, const GameState& state) noexcept
+{
+	return values[canonicalIndex(state)];
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "config.h"
+#include "types.h"
+#include "random.h"
+#include "rules.h"
+
+/**
+ * Maps a number of bits to the signed integer type used for totals of that width
+ */
+template<int Bits> struct TotalType;
+template<> struct TotalType<8> { typedef int8 type; static constexpr int64 DEFAULT_MAX = INT8_MAX; };
+template<> struct TotalType<16> { typedef int16 type; static constexpr int64 DEFAULT_MAX = INT16_MAX; };
+template<> struct TotalType<32> { typedef int32 type; static constexpr int64 DEFAULT_MAX = (1 << 20) - 1; };
+
+/**
+ * The datatype representing a total. Its width is chosen by `TOTAL_BITS`
+ */
+typedef TotalType<TOTAL_BITS>::type Total;
+
+/**
+ * The smallest total a GameState can have. It is reached by turning the dice to 6 at a total of 1
+ */
+static constexpr Total MIN_TOTAL = 1 - StandardRules::FACES;
+
+/**
+ * The largest total a GameState can have. It is chosen by `TOTAL_LIMIT` and defaults to the largest value of 8 and 16 bit
+ * totals. Tables are sized for the full range, so 32 bit totals default to a limit of about a million.
+ */
+#ifdef TOTAL_LIMIT
+static constexpr Total MAX_TOTAL = TOTAL_LIMIT;
+#else
+static constexpr Total MAX_TOTAL = static_cast<Total>(TotalType<TOTAL_BITS>::DEFAULT_MAX);
+#endif // TOTAL_LIMIT
+
+/**
+ * The maximum number of GameStates. The hash function must guarantee 1-universality in {0, 1, ..., NUM_GAME_STATES}.
+ * Every total in {MIN_TOTAL, ..., MAX_TOTAL} has 6 dice faces and 2 active players. The winner does not need to be counted
+ * as it is determined by the total and the active player.
+ */
+static constexpr uint32 NUM_GAME_STATES = static_cast<uint32>(MAX_TOTAL - MIN_TOTAL + 1) * 6 * 2;
+
+static_assert(static_cast<int64>(MAX_TOTAL) - MIN_TOTAL + 1 <= UINT32_MAX / 12, "The states of TOTAL_LIMIT do not fit the hash range");
+
+/**
+ * The datatype representing a player. -1 for player 1, 1 for player 2
+ */
+typedef int8 Player;
+
+/**
+ * The datatype representing a move. Values are {1, 2, ..., 6} corresponding to the number the dice is showing
+ */
+typedef uint8 Move;
+
+/**
+* Represents a complete GameState. Note that 'winner' is set to zero for optimization reasons if no winner is set even though the value is not
+* specified by the Player type.
+* The total comes first so wider totals add as little padding as possible: 4 bytes for 8 bit totals, 6 bytes for 16 bit totals and
+* 8 bytes for 32 bit totals.
+*/
+template<typename TotalT>
+struct BasicGameState {
+	TotalT total;
+	Move lastMove;
+	Player activePlayer;
+	Player winner;
+};
+
+/**
+ * The GameState with the total width chosen by `TOTAL_BITS`
+ */
+typedef BasicGameState<Total> GameState;
+
+static_assert(sizeof(GameState) == (sizeof(Total) + 3 + alignof(Total) - 1) / alignof(Total) * alignof(Total), "GameState must stay tightly packed");
+
+/**
+* The hash function for GameState. Hash values are used to reference entries of the transposition table.
+* States are laid out densely in the order (total, lastMove, activePlayer), so all states sharing a total are stored next
+* to each other and the successors of a state are at most 6 totals (72 entries) away.
+*/
+static inline constexpr uint32 hash(const GameState& state) noexcept
+{
+	return ((static_cast<uint32>(state.total - MIN_TOTAL) * 6 + (state.lastMove - 1)) << 1)
+		| (static_cast<uint32>(state.activePlayer + 1) >> 1);
+}
+
+/**
+ * The face pair of every dice face, indexed by the face: the face classes of `RuleTables` generated from `StandardRules`. The
+ * faces k and 7 - k forbid the same moves, see `isLegalMove`
+ */
+static constexpr const uint8 (&FACE_PAIRS)[StandardRules::FACES + 1] = RuleTablesOf<StandardRules>::VALUE.faceClasses;
+
+/**
+ * The number of face pairs, see `FACE_PAIRS`
+ */
+static constexpr uint32 NUM_FACE_PAIRS = RuleTablesOf<StandardRules>::VALUE.numClasses;
+
+static_assert(NUM_FACE_PAIRS == 3 && FACE_PAIRS[1] == FACE_PAIRS[6] && FACE_PAIRS[2] == FACE_PAIRS[5], "Unexpected face pairs");
+
+/**
+ * The number of GameStates that are distinct under the symmetries of the game, see `canonicalIndex`
+ */
+static constexpr uint32 NUM_CANONICAL_STATES = static_cast<uint32>(MAX_TOTAL - MIN_TOTAL + 1) * NUM_FACE_PAIRS;
+
+/**
+* The canonical index of a GameState. Dice faces of the same pair allow the same moves, so two states with the same total and face
+* pair have isomorphic game trees. Every evaluation is given from the point of view of the active player, so the active player does
+* not matter either. All four such states share one index, which references the entries of the transposition table, the solution
+* database and `solveDP`. Indices are laid out densely in the order (total, face pair), which is the `variantIndex` of
+* `StandardRules`.
+*/
+static inline constexpr uint32 canonicalIndex(const GameState& state) noexcept
+{
+	return static_cast<uint32>(state.total - MIN_TOTAL) * NUM_FACE_PAIRS + FACE_PAIRS[state.lastMove];
+}
+
+/**
+ * Returns the number of canonical indices of every total in {MIN_TOTAL, ..., maxTotal}. Indices are dense, so these are exactly the
+ * indices below the result
+ */
+static inline constexpr uint32 getNumCanonicalStates(const int64& maxTotal) noexcept
+{
+	return static_cast<uint32>(maxTotal - MIN_TOTAL + 1) * NUM_FACE_PAIRS;
+}
+
+/**
+ * Creates a new game state where nobody is the winner yet
+ */
+static constexpr GameState createGameState(const Move& lastMove, const Player& player, const Total& total) noexcept
+{
+	return GameState{total, lastMove, player, 0};
+}
+
+/**
+ * Returns an unbiased random number in {1, 2, ..., 6} from the generator of the calling thread, see `threadRandom`
+ */
+static inline uint8 rollDice() noexcept
+{
+	return rollDice(threadRandom());
+}
+
+/**
+ * Performs the given `Move` on the given `GameState` and returns the resulting `GameState`
+ */
+static inline constexpr GameState performMove(const GameState& state, const Move& move) noexcept
+{
+	Total newTotal = static_cast<Total>(state.total - move);
+	return GameState{
+		newTotal,
+		move,
+		static_cast<Player>(-state.activePlayer),
+		static_cast<Player>((newTotal <= 0) * StandardRules::getMoverOutcome(newTotal) * state.activePlayer)};
+}
+
+/**
+ * Checks whether `move` may follow `lastMove`, meaning the dice is turned to one of the four adjacent faces. The dice can neither
+ * stay on its face nor be turned to the opposite face, see `StandardRules`
+ */
+static inline constexpr bool isLegalMove(const Move& lastMove, const Move& move) noexcept
+{
+	return StandardRules::isLegalMove(lastMove, move);
+}
+
+/**
+ * The legal moves for every dice face: the `RuleTables` generated from `StandardRules` at compile time. `moves[f]` lists the four
+ * moves allowed after the dice showed f in descending order. As every move lowers the total by the number shown, the table holds
+ * the move deltas as well. Row 0 does not correspond to a dice face and is left empty
+ */
+static constexpr const RuleTables<StandardRules>& MOVE_TABLE = RuleTablesOf<StandardRules>::VALUE;
+
+/**
+ * Checks that every dice face allows exactly four moves, which `getPossibleStates` and the search rely on
+ */
+static inline constexpr bool hasFourMovesPerFace() noexcept
+{
+	for (uint8 face = 1; face <= StandardRules::FACES; face++)
+		if (MOVE_TABLE.numMoves[face] != 4)
+			return false;
+
+	return true;
+}
+
+static_assert(hasFourMovesPerFace(), "Every dice face must allow four moves");
+static_assert(MOVE_TABLE.moves[1][0] == 5 && MOVE_TABLE.moves[2][3] == 1 && MOVE_TABLE.moves[4][1] == 5, "Unexpected move table");
+
+/**
+ * Performs every valid move on the given `GameState` and writes the results in the `out` array. The moves are looked up from
+ * `MOVE_TABLE`, so the four successors are generated without any branches
+ */
+static inline void getPossibleStates(GameState out[4], const GameState& lastState)
+{
+	const Move* moves = MOVE_TABLE.moves[lastState.lastMove];
+
+	out[0] = performMove(lastState, moves[0]);
+	out[1] = performMove(lastState, moves[1]);
+	out[2] = performMove(lastState, moves[2]);
+	out[3] = performMove(lastState, moves[3]);
+}
+
+/**
+ * The smallest evaluation of any GameState, a loss for the active player
+ */
+static constexpr int8 MIN_EVAL = -1;
+
+/**
+ * The largest evaluation of any GameState, a win for the active player
+ */
+static constexpr int8 MAX_EVAL = 1;
+
+/**
+ * Narrows the search window (`alpha`, `beta`) to [`MIN_EVAL`, `MAX_EVAL`]. No evaluation lies outside of it, so a search with the
+ * narrowed window still returns exact values, while a win cuts off at once and the negated window cannot overflow
+ */
+static inline void clampSearchWindow(int8& alpha, int8& beta) noexcept
+{
+	if (alpha < MIN_EVAL)
+		alpha = MIN_EVAL;
+	if (beta > MAX_EVAL)
+		beta = MAX_EVAL;
+}
+
+/**
+ * Evaluates the plain state as a base case of the minimax recursion
+ */
+static inline int8 eval(const GameState& state)
+{
+	return (state.total <= 0) * state.winner;
+}
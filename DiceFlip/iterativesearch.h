@@ -0,0 +1,192 @@
+#pragma once
+
+#include "game.h"
+#include "transposition.h"
+#include "stats.h"
+#include <vector>
+
+/**
+ * A single level of an iterative search. It holds everything a call of `miniMax` keeps on the call stack
+ */
+typedef struct _SearchFrame {
+	GameState gameStates[4];
+	uint32 index;
+	uint16 ttEntry;
+	uint8 depth;
+	uint8 i;
+	int8 alpha;
+	int8 beta;
+	int8 windowAlpha;
+	int8 max;
+	Move bestMove;
+} SearchFrame;
+
+/**
+ * A search that runs `miniMax` without recursion. The frames live in a contiguous arena that is allocated once per search depth
+ * and reused by later searches. As the whole search state is kept in here, a search can be paused after any number of nodes
+ * and resumed later, see `continueIterativeSearch`. `nodes` counts the nodes entered since `beginIterativeSearch`, including the
+ * root.
+ */
+typedef struct _IterativeSearch {
+	std::vector<SearchFrame> frames;
+	size_t size;
+	uint64 nodes;
+	int8 result;
+	bool done;
+} IterativeSearch;
+
+/**
+ * Enters the node `state` of the search, just like a call of `miniMax` with the given parameters. Returns true if the value of the
+ * node is known right away, either as a base case or from the transposition table, in which case it is written to `value`.
+ * Otherwise a frame searching the node is pushed
+ */
+static inline bool enterSearchNode(IterativeSearch& search, const GameState& state, const uint8& depth, int8 alpha, int8 beta, int8& value)
+{
+	COUNT_STAT(nodes);
+
+	if (depth == 0 || state.total <= 0)
+	{
+		value = state.activePlayer * eval(state);
+		return true;
+	}
+
+	clampSearchWindow(alpha, beta);
+
+	uint32 index = canonicalIndex(state);
+	uint16 ttEntry = loadTTEntry(index);
+	if (probeTTEntry(ttEntry, depth, alpha, beta, value))
+		return true;
+
+	SearchFrame& frame = search.frames[search.size++];
+	getPossibleStates(frame.gameStates, state);
+	frame.index = index;
+	frame.ttEntry = ttEntry;
+	frame.depth = depth;
+	frame.i = 0;
+	frame.alpha = alpha;
+	frame.beta = beta;
+	frame.windowAlpha = alpha;
+	frame.max = MIN_EVAL - 1;
+	frame.bestMove = 0;
+	return false;
+}
+
+/**
+ * Hands the `value` of the current possible next state to `frame`. Returns true if the frame is finished, either because all possible
+ * next states are checked or because of a beta cutoff
+ */
+static inline bool applyChildValue(SearchFrame& frame, const int8& value)
+{
+	int8 val = -value;
+	if (val > frame.max)
+	{
+		frame.max = val;
+		frame.bestMove = frame.gameStates[frame.i].lastMove;
+	}
+
+	if (val > frame.alpha)
+		frame.alpha = val;
+
+	frame.i++;
+
+	if (frame.alpha >= frame.beta)
+	{
+		COUNT_STAT(betaCutoffs);
+		return true;
+	}
+
+	return frame.i == 4;
+}
+
+/**
+ * Pops the finished top frame, stores its value in the transposition table and returns it
+ */
+static inline int8 popSearchFrame(IterativeSearch& search)
+{
+	const SearchFrame& frame = search.frames[--search.size];
+	storeTTResult(frame.index, frame.ttEntry, frame.depth, frame.max, frame.windowAlpha, frame.beta, frame.bestMove);
+	return frame.max;
+}
+
+/**
+ * Hands the known `value` of a node to its parent frames, popping every frame it finishes
+ */
+static inline void returnSearchValue(IterativeSearch& search, int8 value)
+{
+	while (search.size > 0)
+	{
+		if (!applyChildValue(search.frames[search.size - 1], value))
+			return;
+
+		value = popSearchFrame(search);
+	}
+
+	search.result = value;
+	search.done = true;
+}
+
+/**
+ * Starts an iterative search of `curState` with the same parameters as `miniMax`. The search does not visit any node before
+ * `continueIterativeSearch` is called, except for the root
+ */
+static void beginIterativeSearch(IterativeSearch& search, const GameState& curState, const uint8& depth, const int8& alpha, const int8& beta)
+{
+	if (search.frames.size() < static_cast<size_t>(depth) + 1)
+		search.frames.resize(static_cast<size_t>(depth) + 1);
+
+	search.size = 0;
+	search.nodes = 1;
+	search.result = 0;
+	search.done = false;
+
+	int8 value;
+	if (enterSearchNode(search, curState, depth, alpha, beta, value))
+	{
+		search.result = value;
+		search.done = true;
+	}
+}
+
+/**
+ * Continues the given search for at most `maxNodes` further nodes, or until it is done if `maxNodes` is zero. Returns true once
+ * the search is done, its value can then be read from `result`. Nodes and transposition table accesses happen in exactly the
+ * same order as in `miniMax`.
+ */
+static bool continueIterativeSearch(IterativeSearch& search, const uint64& maxNodes)
+{
+	uint64 nodes = 0;
+
+	while (!search.done)
+	{
+		if (maxNodes != 0 && nodes == maxNodes)
+			return false;
+
+		nodes++;
+		search.nodes++;
+
+		// 
+		// Descend into the current possible next state of the top frame, known values are handed up right away
+		// 
+
+		const SearchFrame& frame = search.frames[search.size - 1];
+
+		int8 value;
+		if (enterSearchNode(search, frame.gameStates[frame.i], frame.depth - 1, -frame.beta, -frame.alpha, value))
+			returnSearchValue(search, value);
+	}
+
+	return true;
+}
+
+/**
+ * Performs the same search as `miniMax` without recursion and returns its value. The frame arena is kept per thread, so
+ * repeated searches do not allocate
+ */
+static inline int8 miniMaxIterative(const GameState& curState, const uint8& depth, const int8& alpha, const int8& beta)
+{
+	static thread_local IterativeSearch search;
+
+	beginIterativeSearch(search, curState, depth, alpha, beta);
+	continueIterativeSearch(search, 0);
+	return search.result;
+}
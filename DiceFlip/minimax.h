@@ -0,0 +1,139 @@
+#pragma once
+
+#include "game.h"
+#include "transposition.h"
+#include "solutiondb.h"
+#include "stats.h"
+#include "iterativesearch.h"
+#include "pvsearch.h"
+
+/**
+ * Performs the minimax algorithm on the `curState` with a maximum depth of `depth`. `alpha` and `beta` values are used for
+ * alpha-beta-pruning. The first call should pass the minimum evaluation value for `alpha` and the maximum evaluation value for `beta`.
+ * The search is fail-soft, so the returned value is exact if it lies within the window, an upper bound if it is at most `alpha` and
+ * a lower bound if it is at least `beta`
+ */
+static int8 miniMax(const GameState& curState, const uint8& depth, int8 alpha, int8 beta)
+{
+	COUNT_STAT(nodes);
+
+	// 
+	// Check if base case applies
+	// 
+	if (depth == 0 || curState.total <= 0)
+		return curState.activePlayer * eval(curState);
+
+	clampSearchWindow(alpha, beta);
+
+	// 
+	// Transposition table lookup
+	// 
+
+	uint32 index = canonicalIndex(curState);
+	uint16 ttEntry = loadTTEntry(index);
+	int8 ttEval;
+	if (probeTTEntry(ttEntry, depth, alpha, beta, ttEval))
+		return ttEval;
+
+	GameState gameStates[4];
+	getPossibleStates(gameStates, curState);
+
+	// 
+	// Check possible next states
+	// 
+
+	const int8 windowAlpha = alpha;
+	int8 max = MIN_EVAL - 1;
+	Move bestMove = 0;
+
+	for(uint8 i = 0; i < 4; i++)
+	{
+		int8 val = -miniMax(gameStates[i], depth - 1, -beta, -alpha);
+		if (val > max)
+		{
+			max = val;
+			bestMove = gameStates[i].lastMove;
+		}
+
+		if (val > alpha)
+			alpha = val;
+
+		if (alpha >= beta)
+		{
+			COUNT_STAT(betaCutoffs);
+			break;
+		}
+	}
+
+	// 
+	// Update transposition table
+	// 
+
+	storeTTResult(index, ttEntry, depth, max, windowAlpha, beta, bestMove);
+
+	return max;
+}
+
+/**
+ * Searches the `curState` with `miniMax`, with `miniMaxPVS` if `PV_SEARCH` is defined or with `miniMaxIterative` if
+ * `ITERATIVE_SEARCH` is defined
+ */
+static inline int8 searchState(const GameState& curState, const uint8& depth, const int8& alpha, const int8& beta)
+{
+#if defined(PV_SEARCH)
+	return miniMaxPVS(curState, depth, alpha, beta);
+#elif defined(ITERATIVE_SEARCH)
+	return miniMaxIterative(curState, depth, alpha, beta);
+#else
+	return miniMax(curState, depth, alpha, beta);
+#endif // PV_SEARCH
+}
+
+/**
+ * Evaluates the `curState` from the point of view of its active player. The evaluation is looked up from the solution database if
+ * it covers the state, otherwise it is searched by `searchState` with a maximum depth of `depth`
+ */
+static inline int8 evaluateState(const GameState& curState, const uint8& depth)
+{
+	if (isInSolutionDB(solutionDB, curState))
+		return getDBEval(getDBEntry(solutionDB, curState));
+
+	return searchState(curState, depth, -128, 127);
+}
+
+/**
+ * Chooses the best move and performs it. The move is looked up from the solution database if it covers the state, otherwise it
+ * is searched by `searchState`.
+ */
+static GameState makeBestMove(const GameState& curState)
+{
+	COUNT_STAT(bestMoveCalls);
+
+	if (isInSolutionDB(solutionDB, curState))
+	{
+		COUNT_STAT(bestMoveLookups);
+		return performMove(curState, getDBMove(getDBEntry(solutionDB, curState)));
+	}
+
+	GameState nextPossible[4];
+	getPossibleStates(nextPossible, curState);
+
+	int8 max = -2;
+	uint8 maxI = 0xFF;
+
+	for (uint8 i = 0; i < 4; i++)
+	{
+		int8 evaluation = -searchState(nextPossible[i], 100, -128, 127);
+
+		if (evaluation >= max)
+		{
+			max = evaluation;
+			maxI = i;
+		}
+	}
+
+	if (max == -2)
+		return nextPossible[0];
+
+	return nextPossible[maxI];
+}
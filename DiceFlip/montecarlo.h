@@ -0,0 +1,219 @@
+#pragma once
+
+#include "game.h"
+#include "minimax.h"
+#include "random.h"
+#include "solver.h"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+/**
+ * The datatype representing how a `Policy` chooses its moves.
+ * 0: PERFECT, the best move of the solved game
+ * 1: RANDOM, a uniformly random legal move drawn with `rollDice`
+ * 2: GREEDY, the largest move that does not end the game, or the smallest move if every move does
+ * 3: MINIMAX, the best move of a `searchState` limited to `depth` moves
+ */
+typedef uint8 PolicyType;
+
+/**
+ * Constant representing the PERFECT policy
+ */
+static constexpr PolicyType POLICY_PERFECT = 0;
+
+/**
+ * Constant representing the RANDOM policy
+ */
+static constexpr PolicyType POLICY_RANDOM = 1;
+
+/**
+ * Constant representing the GREEDY policy
+ */
+static constexpr PolicyType POLICY_GREEDY = 2;
+
+/**
+ * Constant representing the MINIMAX policy
+ */
+static constexpr PolicyType POLICY_MINIMAX = 3;
+
+/**
+ * A strategy playing one side of a Monte-Carlo game. Every policy but `POLICY_RANDOM` is deterministic and only depends on the
+ * canonical state, so its moves are computed once by `buildPolicy` and looked up from `moves` during play. The moves of dice
+ * faces of the same pair are the same, so every move in the table is legal for all states of its canonical index
+ */
+typedef struct _Policy {
+	PolicyType type;
+	uint8 depth;
+	std::vector<Move> moves;
+} Policy;
+
+/**
+ * Returns the move `GREEDY` makes on the given `GameState`. The legal moves of `MOVE_TABLE` are in descending order
+ */
+static inline Move getGreedyMove(const GameState& state) noexcept
+{
+	const Move* moves = MOVE_TABLE.moves[state.lastMove];
+	for (uint8 i = 0; i < 4; i++)
+		if (state.total - moves[i] > 0)
+			return moves[i];
+
+	return moves[3];
+}
+
+/**
+ * Returns the move a depth limited search of the given `GameState` ranks best. Like the solution database, ties go to the last
+ * possible move. Uses the transposition table of the calling thread
+ */
+static Move getMiniMaxMove(const GameState& state, const uint8& depth)
+{
+	GameState gameStates[4];
+	getPossibleStates(gameStates, state);
+
+	int8 max = MIN_EVAL - 1;
+	Move bestMove = 0;
+	for (uint8 i = 0; i < 4; i++)
+	{
+		int8 val = -searchState(gameStates[i], depth - 1, -128, 127);
+		if (val >= max)
+		{
+			max = val;
+			bestMove = gameStates[i].lastMove;
+		}
+	}
+
+	return bestMove;
+}
+
+/**
+ * Prepares `policy` of the given `type` for every game up to `maxTotal`. `depth` is only used by `POLICY_MINIMAX`, which
+ * searches with the transposition table of the calling thread, so it must be allocated
+ */
+static void buildPolicy(Policy& policy, const PolicyType& type, const uint8& depth, const Total& maxTotal)
+{
+	policy.type = type;
+	policy.depth = depth;
+	policy.moves.clear();
+
+	if (type == POLICY_RANDOM)
+		return;
+
+	Solver solver;
+	if (type == POLICY_PERFECT)
+		solver.solve(maxTotal);
+
+	policy.moves.assign(getNumCanonicalStates(maxTotal), 0);
+
+	for (int64 total = 1; total <= maxTotal; total++)
+	{
+		for (Move lastMove = 1; lastMove <= 3; lastMove++)
+		{
+			GameState state = createGameState(lastMove, 1, static_cast<Total>(total));
+			Move& move = policy.moves[canonicalIndex(state)];
+
+			switch (type)
+			{
+			case POLICY_PERFECT:
+				move = solver.bestMove(state);
+				break;
+			case POLICY_GREEDY:
+				move = getGreedyMove(state);
+				break;
+			default:
+				move = getMiniMaxMove(state, depth);
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * Returns the move `policy` makes on the given `GameState`, which must not be over yet
+ */
+static inline Move getPolicyMove(const Policy& policy, const GameState& state, Random& random) noexcept
+{
+	if (policy.type != POLICY_RANDOM)
+		return policy.moves[canonicalIndex(state)];
+
+	Move move;
+	do
+	{
+		move = rollDice(random);
+	} while (!isLegalMove(state.lastMove, move));
+
+	return move;
+}
+
+/**
+ * Plays the game starting at `startState` to the end. `starter` moves for the active player of the start, `other` for the
+ * opponent. Returns true if the starting player wins
+ */
+static inline bool playMonteCarloGame(const GameState& startState, const Policy& starter, const Policy& other, Random& random) noexcept
+{
+	GameState state = startState;
+	while (state.winner == 0)
+	{
+		const Policy& policy = state.activePlayer == startState.activePlayer ? starter : other;
+		state = performMove(state, getPolicyMove(policy, state, random));
+	}
+
+	return state.winner == startState.activePlayer;
+}
+
+/**
+ * The aggregated games of a single starting position. `played` is the number of games actually played, deterministic games are
+ * played once and count `games` times
+ */
+typedef struct _MonteCarloResult {
+	GameState startState;
+	uint64 games;
+	uint64 played;
+	uint64 starterWins;
+} MonteCarloResult;
+
+/**
+ * Plays `gamesPerStart` games from the starting position of every result in `results` on `numThreads` threads and counts the
+ * wins of the starting player. Every worker takes the next starting position until all of them are done. The games of the n-th
+ * starting position draw from the n-th stream of `seed`, see `seedRandom`, so the results only depend on the seed and not on the
+ * number of threads. Games between two deterministic policies always take the same course, so they are played only once.
+ * No transposition table is needed and nothing is written to the console. The policies must cover every starting total
+ */
+static void runMonteCarlo(std::vector<MonteCarloResult>& results, const Policy& starter, const Policy& other, const uint64& gamesPerStart,
+	const unsigned& numThreads, const uint64& seed)
+{
+	const bool deterministic = starter.type != POLICY_RANDOM && other.type != POLICY_RANDOM;
+
+	std::atomic<size_t> nextStart(0);
+	std::vector<std::thread> workers;
+
+	for (unsigned t = 0; t < numThreads; t++)
+	{
+		workers.emplace_back([&results, &starter, &other, &nextStart, gamesPerStart, deterministic, seed]()
+		{
+			Random random;
+
+			for (size_t i = nextStart++; i < results.size(); i = nextStart++)
+			{
+				MonteCarloResult& result = results[i];
+				result.games = gamesPerStart;
+				result.played = deterministic ? 1 : gamesPerStart;
+
+				if (deterministic)
+				{
+					result.starterWins = playMonteCarloGame(result.startState, starter, other, random) ? gamesPerStart : 0;
+					continue;
+				}
+
+				seedRandom(random, seed, static_cast<uint32>(i));
+
+				uint64 wins = 0;
+				for (uint64 g = 0; g < gamesPerStart; g++)
+					wins += playMonteCarloGame(result.startState, starter, other, random);
+				result.starterWins = wins;
+			}
+		});
+	}
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
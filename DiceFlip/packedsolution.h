@@ -0,0 +1,166 @@
+#pragma once
+
+#include "game.h"
+#include "variantsolver.h"
+#include <algorithm>
+#include <vector>
+
+/**
+ * A finished solution that only stores whether each GameState is won, lost or drawn. Once a state is solved exactly, the depth,
+ * node type and best move of its transposition table entry are no longer needed, so every canonical state is packed into 2 bits,
+ * four states per byte. The n-th state corresponds to the GameStates with the canonical index n and is stored in the bits
+ * 2 * (n % 4) and 2 * (n % 4) + 1 of the byte n / 4.
+ * Codes are in the form
+ * 0: not solved,
+ * 1: loss,
+ * 2: draw,
+ * 3: win
+ * from the point of view of the active player. A total takes 3 states, so the solution of every total up to a million fits in
+ * about 750KB.
+ */
+typedef struct _PackedSolution {
+	std::vector<uint8> bits;
+	Total maxTotal;
+} PackedSolution;
+
+/**
+ * Creates the code of a packed state with the given evaluation. See the definition of `PackedSolution` for details
+ */
+static inline constexpr uint8 makePackedCode(const int8& eval) noexcept
+{
+	return static_cast<uint8>(eval + 2);
+}
+
+/**
+ * Extracts the evaluation from the code of a solved packed state
+ */
+static inline constexpr int8 getPackedCodeRating(const uint8& code) noexcept
+{
+	return static_cast<int8>(code) - 2;
+}
+
+/**
+ * Returns the code of the state with the canonical index `index`
+ */
+static inline uint8 getPackedCode(const PackedSolution& solution, const uint32& index) noexcept
+{
+	return (solution.bits[index >> 2] >> ((index & 3) << 1)) & 0b11;
+}
+
+/**
+ * Checks whether the state with the canonical index `index` is solved
+ */
+static inline bool isPackedSolved(const PackedSolution& solution, const uint32& index) noexcept
+{
+	return getPackedCode(solution, index) != 0;
+}
+
+/**
+ * Returns the evaluation of the solved state with the canonical index `index`. This replaces `getRating` for packed solutions
+ */
+static inline int8 getPackedRating(const PackedSolution& solution, const uint32& index) noexcept
+{
+	return getPackedCodeRating(getPackedCode(solution, index));
+}
+
+/**
+ * Stores the evaluation `eval` of the state with the canonical index `index`
+ */
+static inline void setPackedRating(PackedSolution& solution, const uint32& index, const int8& eval) noexcept
+{
+	uint8 shift = (index & 3) << 1;
+	uint8& byte = solution.bits[index >> 2];
+	byte = static_cast<uint8>((byte & ~(0b11 << shift)) | (makePackedCode(eval) << shift));
+}
+
+/**
+ * Checks whether the given `GameState` is covered by the packed solution
+ */
+static inline bool isInPackedSolution(const PackedSolution& solution, const GameState& state) noexcept
+{
+	return state.total <= solution.maxTotal;
+}
+
+/**
+ * Returns the evaluation of the given `GameState` from the point of view of its active player. The state must be covered by the
+ * packed solution
+ */
+static inline int8 getPackedEval(const PackedSolution& solution, const GameState& state) noexcept
+{
+	return getPackedRating(solution, canonicalIndex(state));
+}
+
+/**
+ * Returns the best move of the given `GameState` or zero if the game is already over. The best move is not stored, it is the last
+ * possible move reaching the evaluation of the state, just as in a solution database. The state must be covered by the packed
+ * solution
+ */
+static inline Move getPackedBestMove(const PackedSolution& solution, const GameState& state) noexcept
+{
+	if (state.total <= 0)
+		return 0;
+
+	GameState gameStates[4];
+	getPossibleStates(gameStates, state);
+
+	int8 max = MIN_EVAL - 1;
+	Move bestMove = 0;
+	for (uint8 i = 0; i < 4; i++)
+	{
+		int8 val = -getPackedEval(solution, gameStates[i]);
+		if (val >= max)
+		{
+			max = val;
+			bestMove = gameStates[i].lastMove;
+		}
+	}
+
+	return bestMove;
+}
+
+/**
+ * The number of totals `solvePacked` solves at once
+ */
+static constexpr int64 PACKED_SOLVE_TOTALS = 4096;
+
+/**
+ * Solves every GameState with a total in {MIN_TOTAL, ..., maxTotal} into `solution`, with the same recurrence as `solveDP`. The
+ * totals are solved by `solveVariantRange` in ranges of `PACKED_SOLVE_TOTALS`, each but the first on the boundary of the one
+ * below, and packed right away, so no table of `NUM_CANONICAL_STATES` bytes is needed on the way
+ */
+static void solvePacked(PackedSolution& solution, const Total& maxTotal)
+{
+	solution.bits.assign((static_cast<size_t>(getNumCanonicalStates(maxTotal)) + 3) / 4, 0);
+	solution.maxTotal = maxTotal;
+
+	VariantRange boundary;
+	VariantRange range;
+	VariantRange nextBoundary;
+	for (int64 firstTotal = MIN_TOTAL; firstTotal <= maxTotal; firstTotal += PACKED_SOLVE_TOTALS)
+	{
+		int64 lastTotal = std::min<int64>(firstTotal + PACKED_SOLVE_TOTALS - 1, maxTotal);
+		const VariantRange* incoming = firstTotal == MIN_TOTAL ? nullptr : &boundary;
+		solveVariantRange<StandardRules>(range, incoming, firstTotal, lastTotal);
+
+		uint32 firstIndex = variantIndex<StandardRules>(firstTotal, 1);
+		for (uint32 i = 0; i < range.values.size(); i++)
+			setPackedRating(solution, firstIndex + i, range.values[i]);
+
+		getRangeBoundary<StandardRules>(nextBoundary, range, incoming);
+		boundary.firstTotal = nextBoundary.firstTotal;
+		boundary.lastTotal = nextBoundary.lastTotal;
+		boundary.values.swap(nextBoundary.values);
+	}
+}
+
+/**
+ * Packs the `values` of `solveDP` of every state up to `maxTotal` into `solution`
+ */
+static inline void packSolution(PackedSolution& solution, const int8* values, const Total& maxTotal)
+{
+	solution.bits.assign((static_cast<size_t>(getNumCanonicalStates(maxTotal)) + 3) / 4, 0);
+	solution.maxTotal = maxTotal;
+
+	for (uint32 index = 0; index < getNumCanonicalStates(maxTotal); index++)
+		setPackedRating(solution, index, values[index]);
+}
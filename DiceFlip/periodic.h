@@ -0,0 +1,146 @@
+#pragma once
+
+#include "types.h"
+#include "game.h"
+#include "rules.h"
+#include "variantsolver.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * The solution of a rule variant condensed to its periodic pattern. Every total from `offset` on has the same values as the total
+ * `period` below it. `values` holds the values of every total up to `offset + period - 1` in the layout of `variantIndex`, so
+ * the values of any other total are looked up in O(1), see `getPeriodicValue`. The values do not depend on the active player,
+ * like those of `solveDP`
+ */
+typedef struct _PeriodicSolution {
+	int64 offset;
+	int64 period;
+	std::vector<int8> values;
+} PeriodicSolution;
+
+/**
+ * Returns the total up to `offset + period - 1` that has the same values as `total` in `solution`
+ */
+static inline int64 getPeriodicTotal(const PeriodicSolution& solution, const int64& total) noexcept
+{
+	if (total < solution.offset + solution.period)
+		return total;
+
+	return solution.offset + (total - solution.offset) % solution.period;
+}
+
+/**
+ * Returns the value of the state with the given `total` whose dice shows `face` in O(1) from a `solution` detected for the same
+ * `Rules`, from the point of view of the active player. `total` may be arbitrarily large
+ */
+template<typename Rules = StandardRules>
+static inline int8 getPeriodicValue(const PeriodicSolution& solution, const int64& total, const uint8& face) noexcept
+{
+	return getVariantValue<Rules>(solution.values, getPeriodicTotal(solution, total), face);
+}
+
+/**
+ * Detects the period of a variant from its values up to `maxSearchTotal` and writes it to `solution`. The values of a total only
+ * depend on the values of the `Rules::FACES` totals below it, so once the values of that many consecutive totals repeat, every
+ * total after them repeats as well. Finding the first such repetition therefore proves the period for every total, not just the
+ * solved ones. Every solved total is checked against the detected period anyway. Returns false if no repetition is found up to
+ * `maxSearchTotal`
+ */
+template<typename Rules = StandardRules>
+static bool detectPeriod(PeriodicSolution& solution, const int64& maxSearchTotal)
+{
+	const int64 minTotal = getVariantMinTotal<Rules>();
+	const size_t numClasses = RuleTablesOf<Rules>::VALUE.numClasses;
+	const size_t windowSize = Rules::FACES * numClasses;
+
+	std::vector<int8> values;
+	solveVariant<Rules>(values, maxSearchTotal);
+
+	// 
+	// Find the first window of `Rules::FACES` totals that was seen before, windows are keyed by their bytes
+	// 
+
+	std::unordered_map<std::string, int64> windowEnds;
+	int64 firstEnd = 0;
+	int64 period = 0;
+	for (int64 end = minTotal + Rules::FACES - 1; end <= maxSearchTotal && period == 0; end++)
+	{
+		const char* window = reinterpret_cast<const char*>(values.data()) + (end - minTotal + 1) * numClasses - windowSize;
+		std::pair<std::unordered_map<std::string, int64>::iterator, bool> inserted =
+			windowEnds.emplace(std::string(window, windowSize), end);
+
+		if (!inserted.second)
+		{
+			firstEnd = inserted.first->second;
+			period = end - firstEnd;
+		}
+	}
+
+	if (period == 0)
+		return false;
+
+	// 
+	// The period starts with the first window at the latest, single totals before it may repeat as well
+	// 
+
+	int64 offset = firstEnd - Rules::FACES + 1;
+	while (offset > minTotal)
+	{
+		bool repeats = true;
+		for (uint8 face = 1; face <= Rules::FACES; face++)
+			repeats = repeats
+				&& getVariantValue<Rules>(values, offset - 1, face) == getVariantValue<Rules>(values, offset - 1 + period, face);
+
+		if (!repeats)
+			break;
+		offset--;
+	}
+
+	solution.offset = offset;
+	solution.period = period;
+	solution.values.assign(values.begin(), values.begin() + variantIndex<Rules>(offset + period, 1));
+
+	for (int64 total = minTotal; total <= maxSearchTotal; total++)
+		for (uint8 face = 1; face <= Rules::FACES; face++)
+			if (getVariantValue<Rules>(values, total, face) != getPeriodicValue<Rules>(solution, total, face))
+				return false;
+
+	return true;
+}
+
+/**
+ * Returns the best move of the state with the given `total` whose dice shows `face` in O(1) from a `solution` detected for the same
+ * `Rules`. Like the solution database, ties go to the last of the moves in `RuleTables` order. Returns zero if the game is over
+ */
+template<typename Rules = StandardRules>
+static inline uint8 getPeriodicBestMove(const PeriodicSolution& solution, const int64& total, const uint8& face) noexcept
+{
+	const RuleTables<Rules>& tables = RuleTablesOf<Rules>::VALUE;
+	if (total <= 0)
+		return 0;
+
+	int8 max = -2;
+	uint8 bestMove = 0;
+	for (uint8 i = 0; i < tables.numMoves[face]; i++)
+	{
+		uint8 move = tables.moves[face][i];
+		int8 val = -getPeriodicValue<Rules>(solution, total - move, move);
+		if (val >= max)
+		{
+			max = val;
+			bestMove = move;
+		}
+	}
+
+	return bestMove;
+}
+
+/**
+ * Returns the value of the given `GameState` from a `solution` detected for `StandardRules`, like `getDPValue`
+ */
+static inline int8 getPeriodicEval(const PeriodicSolution& solution, const GameState& state) noexcept
+{
+	return getPeriodicValue<StandardRules>(solution, state.total, state.lastMove);
+}
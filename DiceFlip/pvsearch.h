@@ -0,0 +1,162 @@
+#pragma once
+
+#include "game.h"
+#include "transposition.h"
+#include "stats.h"
+
+/**
+ * The killer move of every search depth, that is the last move that caused a beta cutoff at that depth. It is tried right after the
+ * best move from the transposition table
+ */
+static thread_local Move killerMoves[256] = {};
+
+/**
+ * Moves the possible next state reached by `move` to index `front` of `gameStates`, if it is found behind `front`. Returns the
+ * index after the last state moved to the front
+ */
+static inline uint8 moveToFront(GameState gameStates[4], const uint8& front, const Move& move) noexcept
+{
+	if (move == 0)
+		return front;
+
+	for (uint8 i = front; i < 4; i++)
+	{
+		if (gameStates[i].lastMove == move)
+		{
+			GameState tmp = gameStates[front];
+			gameStates[front] = gameStates[i];
+			gameStates[i] = tmp;
+			return front + 1;
+		}
+	}
+
+	return front;
+}
+
+/**
+ * Orders the possible next states, so the move stored in the transposition table comes first and the killer move comes second
+ */
+static inline void orderPossibleStates(GameState gameStates[4], const Move& ttMove, const Move& killerMove) noexcept
+{
+	uint8 front = moveToFront(gameStates, 0, ttMove);
+	moveToFront(gameStates, front, killerMove);
+}
+
+/**
+ * Performs a fail-soft principal variation search on the `curState` with a maximum depth of `depth`. The first possible next state
+ * is searched with the window (`alpha`, `beta`), all others with a null window first and only searched again if they turn out to
+ * be better. The window must lie within [`MIN_EVAL`, `MAX_EVAL`], see `miniMaxPVS`. The transposition table entries follow the same
+ * contract as those of `miniMax`, so both searches can share a table.
+ */
+static int8 principalVariationSearch(const GameState& curState, const uint8& depth, int8 alpha, int8 beta)
+{
+	COUNT_STAT(nodes);
+
+	// 
+	// Check if base case applies
+	// 
+	if (depth == 0 || curState.total <= 0)
+		return curState.activePlayer * eval(curState);
+
+	// 
+	// Transposition table lookup
+	// 
+
+	uint32 index = canonicalIndex(curState);
+	uint16 ttEntry = loadTTEntry(index);
+	int8 ttEval;
+	if (probeTTEntry(ttEntry, depth, alpha, beta, ttEval))
+		return ttEval;
+
+	GameState gameStates[4];
+	getPossibleStates(gameStates, curState);
+
+	// 
+	// Enhanced transposition cutoff, a single possible next state that is a proven loss for its active player wins the game
+	// 
+
+	for (uint8 i = 0; i < 4; i++)
+	{
+		uint16 nextEntry = gameStates[i].total <= 0 ? 0 : loadTTEntry(canonicalIndex(gameStates[i]));
+		if (getDepth(nextEntry) == PROVEN_DEPTH && getRating(nextEntry) == MIN_EVAL && getNodeType(nextEntry) != NODE_TYPE_LOWER)
+		{
+			COUNT_STAT(betaCutoffs);
+			COUNT_STAT(ttStores);
+			if (ttEntry != 0)
+				COUNT_STAT(ttOverwrites);
+
+			storeTTEntry(index, makeTTVal(PROVEN_DEPTH, MAX_EVAL, NODE_TYPE_EXACT, gameStates[i].lastMove));
+			return MAX_EVAL;
+		}
+	}
+
+	orderPossibleStates(gameStates, getBestMove(ttEntry), killerMoves[depth]);
+
+	// 
+	// Check possible next states
+	// 
+
+	const int8 windowAlpha = alpha;
+	int8 max = MIN_EVAL - 1;
+	Move bestMove = 0;
+
+	for (uint8 i = 0; i < 4; i++)
+	{
+		const GameState& possibleNext = gameStates[i];
+
+		int8 val;
+		if (depth == 1 || possibleNext.total <= 0)
+		{
+			COUNT_STAT(nodes);
+			val = -possibleNext.activePlayer * eval(possibleNext);
+		}
+		else if (i == 0)
+		{
+			val = -principalVariationSearch(possibleNext, depth - 1, -beta, -alpha);
+		}
+		else
+		{
+			val = -principalVariationSearch(possibleNext, depth - 1, -alpha - 1, -alpha);
+			if (val > alpha && val < beta)
+			{
+				COUNT_STAT(researches);
+				val = -principalVariationSearch(possibleNext, depth - 1, -beta, -val);
+			}
+		}
+
+		if (val > max)
+		{
+			max = val;
+			bestMove = possibleNext.lastMove;
+		}
+
+		if (val > alpha)
+			alpha = val;
+
+		if (alpha >= beta)
+		{
+			COUNT_STAT(betaCutoffs);
+			killerMoves[depth] = possibleNext.lastMove;
+			break;
+		}
+	}
+
+	// 
+	// Update transposition table
+	// 
+
+	storeTTResult(index, ttEntry, depth, max, windowAlpha, beta, bestMove);
+
+	return max;
+}
+
+/**
+ * Searches the `curState` with `principalVariationSearch`. The window is first narrowed by `clampSearchWindow`, so the full window
+ * becomes [-1, 1], which the null windows (-1, 0) and (0, 1) split into its three values
+ */
+static inline int8 miniMaxPVS(const GameState& curState, const uint8& depth, int8 alpha, int8 beta)
+{
+	clampSearchWindow(alpha, beta);
+
+	return principalVariationSearch(curState, depth, alpha, beta);
+}
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "types.h"
+#include <stddef.h>
+
+/**
+ * The state of a xoshiro256** random number generator. The same seed always produces the same sequence, on every platform.
+ * A generator must only be used by one thread at a time, so every thread uses its own, see `threadRandom`
+ */
+typedef struct _Random {
+	uint64 s[4];
+} Random;
+
+/**
+ * Advances the splitmix64 generator `x` and returns its next output. Used to spread a single seed over the 256 bits of a `Random`
+ */
+static inline uint64 splitMix64(uint64& x) noexcept
+{
+	uint64 z = (x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ * Rotates `x` left by `k` bits
+ */
+static inline constexpr uint64 rotateLeft(const uint64& x, const int& k) noexcept
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * Returns the next 64 random bits of `random`
+ */
+static inline uint64 nextRandom(Random& random) noexcept
+{
+	uint64* s = random.s;
+	uint64 result = rotateLeft(s[1] * 5, 7) * 9;
+	uint64 t = s[1] << 17;
+
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotateLeft(s[3], 45);
+
+	return result;
+}
+
+/**
+ * Advances `random` by 2^128 outputs. Generators seeded alike and jumped a different number of times produce sequences that
+ * do not overlap in practice
+ */
+static void jumpRandom(Random& random) noexcept
+{
+	static constexpr uint64 JUMP[4] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+
+	uint64 s[4] = {0, 0, 0, 0};
+	for (uint8 i = 0; i < 4; i++)
+	{
+		for (uint8 b = 0; b < 64; b++)
+		{
+			if (JUMP[i] & (1ULL << b))
+			{
+				s[0] ^= random.s[0];
+				s[1] ^= random.s[1];
+				s[2] ^= random.s[2];
+				s[3] ^= random.s[3];
+			}
+			nextRandom(random);
+		}
+	}
+
+	for (uint8 i = 0; i < 4; i++)
+		random.s[i] = s[i];
+}
+
+/**
+ * Seeds `random` with `seed` and jumps it to its `stream`-th independent sequence, see `jumpRandom`. Threads working on the
+ * same job use the same seed and their thread index as `stream`, so every run with that seed repeats every thread's sequence
+ */
+static void seedRandom(Random& random, const uint64& seed, const uint32& stream = 0) noexcept
+{
+	uint64 x = seed;
+	for (uint8 i = 0; i < 4; i++)
+		random.s[i] = splitMix64(x);
+
+	for (uint32 i = 0; i < stream; i++)
+		jumpRandom(random);
+}
+
+/**
+ * Maps 32 random `bits` to a number in {1, 2, ..., 6} by multiplying them with 6. Returns false if the product is one of the
+ * 4 of 2^32 values that would make some faces more likely than others, in which case the caller needs new bits
+ */
+static inline bool mapDiceRoll(const uint32& bits, uint8& roll) noexcept
+{
+	uint64 product = static_cast<uint64>(bits) * 6;
+	roll = static_cast<uint8>((product >> 32) + 1);
+	return static_cast<uint32>(product) >= 4;
+}
+
+/**
+ * Returns an unbiased random number in {1, 2, ..., 6} from `random`
+ */
+static inline uint8 rollDice(Random& random) noexcept
+{
+	uint8 roll;
+	while (true)
+	{
+		uint64 bits = nextRandom(random);
+		if (mapDiceRoll(static_cast<uint32>(bits >> 32), roll) || mapDiceRoll(static_cast<uint32>(bits), roll))
+			return roll;
+	}
+}
+
+/**
+ * Writes `count` unbiased random numbers in {1, 2, ..., 6} from `random` to `rolls`. Every output of the generator yields two
+ * rolls, so this needs about half the generator calls of `rollDice`
+ */
+static inline void fillRolls(Random& random, uint8* rolls, const size_t& count) noexcept
+{
+	size_t i = 0;
+	while (i < count)
+	{
+		uint64 bits = nextRandom(random);
+		if (mapDiceRoll(static_cast<uint32>(bits >> 32), rolls[i]))
+			i++;
+		if (i < count && mapDiceRoll(static_cast<uint32>(bits), rolls[i]))
+			i++;
+	}
+}
+
+/**
+ * The seed every thread's generator starts with until `seedThreadRandom` is called
+ */
+static constexpr uint64 DEFAULT_RANDOM_SEED = 0x44494345464C4950ULL;
+
+/**
+ * Returns the generator of the calling thread. Threads never share a generator, so rolling dice on many threads does not
+ * serialize them
+ */
+static inline Random& threadRandom() noexcept
+{
+	static thread_local Random random = [] {
+		Random seeded;
+		seedRandom(seeded, DEFAULT_RANDOM_SEED);
+		return seeded;
+	}();
+	return random;
+}
+
+/**
+ * Seeds the generator of the calling thread, see `seedRandom`
+ */
+static inline void seedThreadRandom(const uint64& seed, const uint32& stream = 0) noexcept
+{
+	seedRandom(threadRandom(), seed, stream);
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "game.h"
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+/**
+ * The datatype representing the format of the results file.
+ * 0: LEGACY, lines in the form {dice:1,startingplayer:-1,total:66,eval:1}
+ * 1: JSONL, one JSON object per line in the form {"dice":1,"startingplayer":-1,"total":66,"eval":1}
+ * 2: CSV, a header line followed by lines in the form 1,-1,66,1
+ * 3: BINARY, a `ResultsFileHeader` followed by one `ResultRecord` per game
+ */
+typedef uint8 ResultsFormat;
+
+/**
+ * Constant representing the LEGACY results format
+ */
+static constexpr ResultsFormat RESULTS_FORMAT_LEGACY = 0;
+
+/**
+ * Constant representing the JSONL results format
+ */
+static constexpr ResultsFormat RESULTS_FORMAT_JSONL = 1;
+
+/**
+ * Constant representing the CSV results format
+ */
+static constexpr ResultsFormat RESULTS_FORMAT_CSV = 2;
+
+/**
+ * Constant representing the BINARY results format
+ */
+static constexpr ResultsFormat RESULTS_FORMAT_BINARY = 3;
+
+/**
+ * Magic number at the start of every binary results file. Reads "DFRS" in a little endian file
+ */
+static constexpr uint32 RESULTS_FILE_MAGIC = 0x53524644;
+
+/**
+ * Version of the binary results format. Must be increased whenever the layout of the header or the records changes
+ */
+static constexpr uint32 RESULTS_FILE_VERSION = 1;
+
+/**
+ * The header of a binary results file. It is followed by `numRecords` records
+ */
+typedef struct _ResultsFileHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 numRecords;
+	uint32 recordSize;
+} ResultsFileHeader;
+
+/**
+ * A single game in a binary results file
+ */
+typedef struct _ResultRecord {
+	int32 total;
+	Move dice;
+	Player startingPlayer;
+	int8 eval;
+	uint8 reserved;
+} ResultRecord;
+
+static_assert(sizeof(ResultRecord) == 8, "Unexpected ResultRecord layout");
+
+/**
+ * Collects the results of a sweep in a reusable buffer, so the whole file is written at once by `flushResults`
+ */
+typedef struct _ResultsWriter {
+	ResultsFormat format;
+	uint32 numRecords;
+	std::vector<char> buffer;
+} ResultsWriter;
+
+/**
+ * Returns the default path of a results file in the given `format`
+ */
+static inline const char* getResultsPath(const ResultsFormat& format) noexcept
+{
+	switch (format)
+	{
+	case RESULTS_FORMAT_JSONL:
+		return "./results.jsonl";
+	case RESULTS_FORMAT_CSV:
+		return "./results.csv";
+	case RESULTS_FORMAT_BINARY:
+		return "./results.bin";
+	default:
+		return "./results.txt";
+	}
+}
+
+/**
+ * Appends the raw bytes of `data` to the buffer of `writer`
+ */
+static inline void appendBytes(ResultsWriter& writer, const void* data, const size_t& size)
+{
+	const char* bytes = reinterpret_cast<const char*>(data);
+	writer.buffer.insert(writer.buffer.end(), bytes, bytes + size);
+}
+
+/**
+ * Appends the null terminated `text` to the buffer of `writer`
+ */
+static inline void appendText(ResultsWriter& writer, const char* text)
+{
+	appendBytes(writer, text, strlen(text));
+}
+
+/**
+ * Appends the decimal representation of `value` to the buffer of `writer`
+ */
+static inline void appendInt(ResultsWriter& writer, const int64& value)
+{
+	char digits[24];
+	char* end = digits + sizeof(digits);
+	char* begin = end;
+
+	uint64 magnitude = value < 0 ? 0 - static_cast<uint64>(value) : static_cast<uint64>(value);
+	do
+	{
+		*--begin = static_cast<char>('0' + magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude != 0);
+
+	if (value < 0)
+		*--begin = '-';
+
+	appendBytes(writer, begin, end - begin);
+}
+
+/**
+ * Empties `writer` and starts a results file in the given `format`. `expectedRecords` is the number of games that will be written,
+ * it is only used to reserve the buffer
+ */
+static void beginResults(ResultsWriter& writer, const ResultsFormat& format, const size_t& expectedRecords)
+{
+	writer.format = format;
+	writer.numRecords = 0;
+	writer.buffer.clear();
+	writer.buffer.reserve(sizeof(ResultsFileHeader) + expectedRecords * 48);
+
+	if (format == RESULTS_FORMAT_CSV)
+	{
+		appendText(writer, "dice,startingplayer,total,eval\n");
+	}
+	else if (format == RESULTS_FORMAT_BINARY)
+	{
+		ResultsFileHeader header = {RESULTS_FILE_MAGIC, RESULTS_FILE_VERSION, 0, sizeof(ResultRecord)};
+		appendBytes(writer, &header, sizeof(header));
+	}
+}
+
+/**
+ * Appends the result of the game starting at `startState` with the evaluation `eval` to `writer`
+ */
+static void writeResult(ResultsWriter& writer, const GameState& startState, const int8& eval)
+{
+	writer.numRecords++;
+
+	switch (writer.format)
+	{
+	case RESULTS_FORMAT_JSONL:
+	{
+		appendText(writer, "{\"dice\":");
+		appendInt(writer, startState.lastMove);
+		appendText(writer, ",\"startingplayer\":");
+		appendInt(writer, startState.activePlayer);
+		appendText(writer, ",\"total\":");
+		appendInt(writer, startState.total);
+		appendText(writer, ",\"eval\":");
+		appendInt(writer, eval);
+		appendText(writer, "}\n");
+	} break;
+	case RESULTS_FORMAT_CSV:
+	{
+		appendInt(writer, startState.lastMove);
+		appendText(writer, ",");
+		appendInt(writer, startState.activePlayer);
+		appendText(writer, ",");
+		appendInt(writer, startState.total);
+		appendText(writer, ",");
+		appendInt(writer, eval);
+		appendText(writer, "\n");
+	} break;
+	case RESULTS_FORMAT_BINARY:
+	{
+		ResultRecord record = {static_cast<int32>(startState.total), startState.lastMove, startState.activePlayer, eval, 0};
+		appendBytes(writer, &record, sizeof(record));
+	} break;
+	default:
+	{
+		appendText(writer, "{dice:");
+		appendInt(writer, startState.lastMove);
+		appendText(writer, ",startingplayer:");
+		appendInt(writer, startState.activePlayer);
+		appendText(writer, ",total:");
+		appendInt(writer, startState.total);
+		appendText(writer, ",eval:");
+		appendInt(writer, eval);
+		appendText(writer, "}\n");
+	} break;
+	}
+}
+
+/**
+ * Writes everything collected by `writer` to `path` with a single write. Text formats are written in text mode, just like the
+ * std::ofstream they replace. Returns false if the file could not be written
+ */
+static bool flushResults(ResultsWriter& writer, const char* path)
+{
+	if (writer.format == RESULTS_FORMAT_BINARY)
+		memcpy(writer.buffer.data() + offsetof(ResultsFileHeader, numRecords), &writer.numRecords, sizeof(writer.numRecords));
+
+	FILE* out = fopen(path, writer.format == RESULTS_FORMAT_BINARY ? "wb" : "w");
+	if (out == nullptr)
+		return false;
+
+	bool success = writer.buffer.empty() || fwrite(writer.buffer.data(), 1, writer.buffer.size(), out) == writer.buffer.size();
+
+	return fclose(out) == 0 && success;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "types.h"
+#include <string>
+
+/**
+ * A family of rule variants for a dice with `Faces` faces. The dice may never be turned to the face it shows. If `ForbidOpposite`
+ * is set, it may not be turned to the opposite face either, which is the face k and Faces + 1 - k. The player who moves the total
+ * to zero or below loses, unless `Misere` is set, in which case that player wins. If `OvershootLoses` is set, the player who moves
+ * the total below zero always loses, so only bringing the total to zero exactly is decided by `Misere`.
+ * Any other type providing the same members can be used as rules, too:
+ * FACES, the number of faces of the dice, numbered 1 to FACES,
+ * isLegalMove(lastMove, move), whether the dice may be turned from the face `lastMove` to the face `move`, and
+ * getMoverOutcome(newTotal), the outcome for the player who moved the total to `newTotal` of zero or below, 1 for a win and -1
+ * for a loss.
+ * Everything is constexpr, so `RuleTables` and the solver of `variantsolver.h` are generated per variant at compile time and
+ * never branch on the rules at runtime.
+ */
+template<uint8 Faces, bool ForbidOpposite, bool Misere, bool OvershootLoses>
+struct DiceRules
+{
+	static_assert(Faces >= 2 && Faces <= 31, "Dice faces must fit the bitmasks of RuleTables");
+
+	static constexpr uint8 FACES = Faces;
+
+	static constexpr bool isLegalMove(const uint8& lastMove, const uint8& move) noexcept
+	{
+		return move >= 1 && move <= Faces && move != lastMove && !(ForbidOpposite && move + lastMove == Faces + 1);
+	}
+
+	static constexpr int8 getMoverOutcome(const int64& newTotal) noexcept
+	{
+		return (OvershootLoses && newTotal < 0) ? -1 : (Misere ? 1 : -1);
+	}
+
+	/**
+	 * Returns a short description of the variant, e.g. "d6 no opposite"
+	 */
+	static std::string getName()
+	{
+		return "d" + std::to_string(Faces) + (ForbidOpposite ? " no opposite" : "") + (Misere ? " misere" : "")
+			+ (OvershootLoses ? " exact" : "");
+	}
+};
+
+/**
+ * The rules of DiceFlip: a six-faced dice that may be turned neither to the face it shows nor to the opposite face. The player
+ * who moves the total to zero or below loses
+ */
+typedef DiceRules<6, true, false, false> StandardRules;
+
+/**
+ * Tables generated from a rules type at compile time.
+ * `moves[f]` lists the `numMoves[f]` legal moves after the dice showed f in descending order. Row 0 is left empty.
+ * `faceClasses[f]` is the class of the face f. Faces with the same legal moves have isomorphic game trees, so they form one of the
+ * `numClasses` classes that the canonical index of a variant is built from.
+ */
+template<typename Rules>
+struct RuleTables
+{
+	uint8 moves[Rules::FACES + 1][Rules::FACES];
+	uint8 numMoves[Rules::FACES + 1];
+	uint8 faceClasses[Rules::FACES + 1];
+	uint8 numClasses;
+
+	constexpr RuleTables() : moves{}, numMoves{}, faceClasses{}, numClasses(0)
+	{
+		uint32 masks[Rules::FACES + 1] = {};
+
+		for (uint8 face = 1; face <= Rules::FACES; face++)
+		{
+			for (uint8 move = Rules::FACES; move >= 1; move--)
+			{
+				if (Rules::isLegalMove(face, move))
+				{
+					moves[face][numMoves[face]++] = move;
+					masks[face] |= 1u << move;
+				}
+			}
+
+			// 
+			// Faces allowing the same moves share a class, classes are numbered in the order of their first face
+			// 
+
+			faceClasses[face] = numClasses;
+			for (uint8 other = 1; other < face; other++)
+			{
+				if (masks[other] == masks[face])
+				{
+					faceClasses[face] = faceClasses[other];
+					break;
+				}
+			}
+
+			if (faceClasses[face] == numClasses)
+				numClasses++;
+		}
+	}
+};
+
+/**
+ * The tables of every rules type, see `RuleTables`
+ */
+template<typename Rules>
+struct RuleTablesOf
+{
+	static constexpr RuleTables<Rules> VALUE = RuleTables<Rules>();
+};
+
+template<typename Rules>
+constexpr RuleTables<Rules> RuleTablesOf<Rules>::VALUE;
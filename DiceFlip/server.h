@@ -0,0 +1,598 @@
+#pragma once
+
+#include "game.h"
+#include "periodic.h"
+#include "solver.h"
+#include <atomic>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "ws2_32.lib")
+#endif // _MSC_VER
+#else
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif // __linux__
+#endif // _WIN32
+
+/**
+ * The port the move server listens on unless another one is given
+ */
+static constexpr uint16 DEFAULT_SERVER_PORT = 7777;
+
+/**
+ * The longest request line the move server accepts. Connections sending longer lines are closed
+ */
+static constexpr size_t SERVER_MAX_LINE = 64;
+
+/**
+ * The number of bytes the move server receives from a connection at once
+ */
+static constexpr size_t SERVER_READ_BYTES = 16384;
+
+/**
+ * The number of response bytes the move server holds for a connection before it stops reading its requests. Reading resumes
+ * once the client received enough of them, so a client that never reads cannot make the server buffer without bound
+ */
+static constexpr size_t SERVER_MAX_OUTPUT = 65536;
+
+/**
+ * The number of events the move server handles per wakeup
+ */
+static constexpr int SERVER_MAX_EVENTS = 256;
+
+/**
+ * The milliseconds the move server waits for events before it checks whether it should stop
+ */
+static constexpr int SERVER_POLL_MILLISECONDS = 100;
+
+/**
+ * The flags of every send of the move server. A client closing its connection early must not kill the server by SIGPIPE
+ */
+#ifdef MSG_NOSIGNAL
+static constexpr int SERVER_SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static constexpr int SERVER_SEND_FLAGS = 0;
+#endif // MSG_NOSIGNAL
+
+#ifdef _WIN32
+typedef SOCKET ServerSocket;
+static constexpr ServerSocket INVALID_SERVER_SOCKET = INVALID_SOCKET;
+#else
+typedef int ServerSocket;
+static constexpr ServerSocket INVALID_SERVER_SOCKET = -1;
+#endif // _WIN32
+
+/**
+ * A client connection of the move server. `input` holds the start of a request line that has not been received completely,
+ * `output` the responses that could not be sent yet. `closing` is set once the client finished sending or asked to be
+ * disconnected, the connection is then closed as soon as `output` is sent
+ */
+typedef struct _ServerConnection {
+	ServerSocket socket;
+	std::string input;
+	std::string output;
+	bool closing;
+} ServerConnection;
+
+/**
+ * Closes a socket of the move server
+ */
+static inline void closeServerSocket(const ServerSocket& socket) noexcept
+{
+#ifdef _WIN32
+	closesocket(socket);
+#else
+	close(socket);
+#endif // _WIN32
+}
+
+/**
+ * Switches a socket of the move server to non-blocking mode. Returns false on failure
+ */
+static inline bool setNonBlocking(const ServerSocket& socket) noexcept
+{
+#ifdef _WIN32
+	u_long enabled = 1;
+	return ioctlsocket(socket, FIONBIO, &enabled) == 0;
+#else
+	int flags = fcntl(socket, F_GETFL, 0);
+	return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif // _WIN32
+}
+
+/**
+ * Checks whether the last socket call failed only because it would have blocked
+ */
+static inline bool wouldBlock() noexcept
+{
+#ifdef _WIN32
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif // _WIN32
+}
+
+/**
+ * Parses the decimal number, optionally negative, at `text` up to `end` into `value` and moves `text` behind it. Returns false if
+ * there is no number
+ */
+static inline bool parseRequestNumber(const char*& text, const char* end, int64& value) noexcept
+{
+	bool negative = text < end && *text == '-';
+	if (negative)
+		text++;
+
+	const char* start = text;
+	uint64 magnitude = 0;
+	while (text < end && *text >= '0' && *text <= '9' && text - start < 18)
+		magnitude = magnitude * 10 + static_cast<uint64>(*text++ - '0');
+
+	if (text == start)
+		return false;
+
+	value = negative ? -static_cast<int64>(magnitude) : static_cast<int64>(magnitude);
+	return true;
+}
+
+/**
+ * Appends the decimal number `value` and a newline to `out`
+ */
+static inline void appendResponseNumber(std::string& out, const int64& value)
+{
+	char digits[24];
+	int length = 0;
+	uint64 magnitude = value < 0 ? static_cast<uint64>(-value) : static_cast<uint64>(value);
+	do
+	{
+		digits[length++] = static_cast<char>('0' + magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude != 0);
+
+	if (value < 0)
+		out.push_back('-');
+	while (length > 0)
+		out.push_back(digits[--length]);
+	out.push_back('\n');
+}
+
+/**
+ * Answers a single request line of the move server protocol and appends the response to `out`. Requests are
+ * "move <total> <dice>", answered by "move <best move>", and "eval <total> <dice>", answered by "eval <evaluation>", both from the
+ * point of view of the player to move. Totals covered by `solver` are looked up from its table, larger ones from `periodic`. Both
+ * are read-only, so the answer only depends on the request. Games that are already over have the best move 0. Anything else is
+ * answered by "error". Returns false if the connection asked to be closed by "quit"
+ */
+static bool answerRequest(const Solver& solver, const PeriodicSolution& periodic, const char* line, const char* end, std::string& out)
+{
+	bool isMove = end - line > 5 && memcmp(line, "move ", 5) == 0;
+	bool isEval = end - line > 5 && memcmp(line, "eval ", 5) == 0;
+
+	if (!isMove && !isEval)
+	{
+		if (end - line == 4 && memcmp(line, "quit", 4) == 0)
+			return false;
+
+		out += "error\n";
+		return true;
+	}
+
+	const char* text = line + 5;
+	int64 total;
+	int64 dice;
+	if (!parseRequestNumber(text, end, total) || text == end || *text++ != ' ' || !parseRequestNumber(text, end, dice) || text != end
+		|| dice < 1 || dice > 6 || total < MIN_TOTAL)
+	{
+		out += "error\n";
+		return true;
+	}
+
+	const Move face = static_cast<Move>(dice);
+
+	if (total <= solver.getMaxTotal())
+	{
+		GameState state = createGameState(face, 1, static_cast<Total>(total));
+		out += isMove ? "move " : "eval ";
+		appendResponseNumber(out, isMove ? (total <= 0 ? 0 : solver.bestMove(state)) : solver.evaluate(state));
+		return true;
+	}
+
+	out += isMove ? "move " : "eval ";
+	appendResponseNumber(out, isMove ? getPeriodicBestMove(periodic, total, face) : getPeriodicValue(periodic, total, face));
+	return true;
+}
+
+/**
+ * Answers every complete request line of `data` for `connection`, in order, and keeps the start of an incomplete line for the next
+ * call. Pipelined requests are answered at once and their responses sent together. Returns false if the connection should be
+ * closed, because of "quit" or a line longer than `SERVER_MAX_LINE`
+ */
+static bool handleRequests(const Solver& solver, const PeriodicSolution& periodic, ServerConnection& connection, const char* data,
+	const size_t& size)
+{
+	const char* end = data + size;
+
+	// 
+	// Complete the line left over from the last call first
+	// 
+
+	if (!connection.input.empty())
+	{
+		const char* newline = static_cast<const char*>(memchr(data, '\n', size));
+		if (newline == nullptr)
+		{
+			connection.input.append(data, size);
+			return connection.input.size() <= SERVER_MAX_LINE;
+		}
+
+		connection.input.append(data, newline);
+		if (connection.input.size() > SERVER_MAX_LINE)
+			return false;
+
+		const char* lineEnd = connection.input.data() + connection.input.size();
+		if (lineEnd > connection.input.data() && lineEnd[-1] == '\r')
+			lineEnd--;
+
+		if (!answerRequest(solver, periodic, connection.input.data(), lineEnd, connection.output))
+			return false;
+
+		connection.input.clear();
+		data = newline + 1;
+	}
+
+	while (data < end)
+	{
+		const char* newline = static_cast<const char*>(memchr(data, '\n', end - data));
+		if (newline == nullptr)
+		{
+			connection.input.assign(data, end);
+			return connection.input.size() <= SERVER_MAX_LINE;
+		}
+
+		if (static_cast<size_t>(newline - data) > SERVER_MAX_LINE)
+			return false;
+
+		const char* lineEnd = newline > data && newline[-1] == '\r' ? newline - 1 : newline;
+		if (!answerRequest(solver, periodic, data, lineEnd, connection.output))
+			return false;
+
+		data = newline + 1;
+	}
+
+	return true;
+}
+
+/**
+ * Sends as much of the pending output of `connection` as the socket takes. Returns false if the connection failed
+ */
+static bool flushConnection(ServerConnection& connection)
+{
+	size_t sent = 0;
+	while (sent < connection.output.size())
+	{
+		int result = send(connection.socket, connection.output.data() + sent, static_cast<int>(connection.output.size() - sent),
+			SERVER_SEND_FLAGS);
+		if (result < 0)
+		{
+			if (!wouldBlock())
+				return false;
+			break;
+		}
+
+		sent += static_cast<size_t>(result);
+	}
+
+	connection.output.erase(0, sent);
+	return true;
+}
+
+/**
+ * Sends the pending output of `connection`, see `flushConnection`. Returns false if the connection failed, or if it is closing
+ * and everything has been sent
+ */
+static inline bool sendPendingOutput(ServerConnection& connection)
+{
+	return flushConnection(connection) && !(connection.closing && connection.output.empty());
+}
+
+/**
+ * Checks whether the move server reads further requests of `connection`, which it does until it is closing and while fewer than
+ * `SERVER_MAX_OUTPUT` response bytes wait to be sent
+ */
+static inline bool isReadingRequests(const ServerConnection& connection) noexcept
+{
+	return !connection.closing && connection.output.size() < SERVER_MAX_OUTPUT;
+}
+
+#ifdef __linux__
+/**
+ * Returns the epoll events the move server watches `connection` for, see `isReadingRequests`
+ */
+static inline uint32 getWatchedEvents(const ServerConnection& connection) noexcept
+{
+	return (isReadingRequests(connection) ? static_cast<uint32>(EPOLLIN | EPOLLRDHUP) : 0u)
+		| (connection.output.empty() ? 0u : static_cast<uint32>(EPOLLOUT));
+}
+#endif // __linux__
+
+/**
+ * Receives everything that arrived on `connection`, answers all complete requests and sends the responses. Stops reading once
+ * `isReadingRequests` fails and the socket takes no more output. A client that finished sending, or asked to be disconnected,
+ * still gets every response before the connection is closed. Returns false if the connection failed or everything was sent to a
+ * closing connection
+ */
+static bool serviceConnection(const Solver& solver, const PeriodicSolution& periodic, ServerConnection& connection)
+{
+	char buffer[SERVER_READ_BYTES];
+
+	for (;;)
+	{
+		if (!isReadingRequests(connection))
+		{
+			if (!flushConnection(connection))
+				return false;
+			if (!isReadingRequests(connection))
+				break;
+		}
+
+		int result = recv(connection.socket, buffer, static_cast<int>(sizeof(buffer)), 0);
+		if (result == 0)
+		{
+			connection.closing = true;
+			break;
+		}
+
+		if (result < 0)
+		{
+			if (!wouldBlock())
+				return false;
+			break;
+		}
+
+		if (!handleRequests(solver, periodic, connection, buffer, static_cast<size_t>(result)))
+		{
+			connection.closing = true;
+			break;
+		}
+
+		if (static_cast<size_t>(result) < sizeof(buffer))
+			break;
+	}
+
+	return sendPendingOutput(connection);
+}
+
+/**
+ * Accepts every pending connection on `listener` and appends them to `accepted` as non-blocking sockets with Nagle's algorithm
+ * disabled, so single responses leave at once
+ */
+static void acceptConnections(const ServerSocket& listener, std::vector<ServerSocket>& accepted)
+{
+	for (;;)
+	{
+		ServerSocket socket = accept(listener, nullptr, nullptr);
+		if (socket == INVALID_SERVER_SOCKET)
+			return;
+
+		int enabled = 1;
+		setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&enabled), sizeof(enabled));
+
+		if (!setNonBlocking(socket))
+		{
+			closeServerSocket(socket);
+			continue;
+		}
+
+		accepted.push_back(socket);
+	}
+}
+
+/**
+ * Opens a non-blocking socket listening on `port` of every interface. Returns `INVALID_SERVER_SOCKET` on failure
+ */
+static ServerSocket openListener(const uint16& port)
+{
+	ServerSocket listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener == INVALID_SERVER_SOCKET)
+		return INVALID_SERVER_SOCKET;
+
+	int enabled = 1;
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&enabled), sizeof(enabled));
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(port);
+
+	if (bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0
+		|| !setNonBlocking(listener))
+	{
+		closeServerSocket(listener);
+		return INVALID_SERVER_SOCKET;
+	}
+
+	return listener;
+}
+
+/**
+ * Serves the move server protocol of `answerRequest` on `port` until `stop` is set, with totals beyond `solver` answered from
+ * `periodic`. Every connection may pipeline any number of requests and play any number of games, the requests carry the whole
+ * state. A single thread serves every connection from one event loop, with epoll on Linux and poll, or WSAPoll on Windows,
+ * elsewhere. Every wakeup handles up to `SERVER_MAX_EVENTS` ready connections, and every ready connection has all received
+ * requests answered with a single send. A connection is only watched for requests while `isReadingRequests` holds and for
+ * output while responses wait. The lookups take nanoseconds, so the loop never waits for anything but the sockets. `solver`
+ * must stay unchanged while the server runs. Returns false if the port could not be opened
+ */
+static inline bool runMoveServer(const Solver& solver, const PeriodicSolution& periodic, const uint16& port, const std::atomic<bool>& stop)
+{
+#ifdef _WIN32
+	WSADATA wsaData;
+	if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+		return false;
+#endif // _WIN32
+
+	ServerSocket listener = openListener(port);
+	if (listener == INVALID_SERVER_SOCKET)
+	{
+#ifdef _WIN32
+		WSACleanup();
+#endif // _WIN32
+		return false;
+	}
+
+	std::vector<ServerSocket> accepted;
+
+#ifdef __linux__
+	// 
+	// Connections are registered with epoll and found by their socket, which is a small number
+	// 
+
+	int epoll = epoll_create1(0);
+	epoll_event listenEvent = {};
+	listenEvent.events = EPOLLIN;
+	listenEvent.data.fd = listener;
+	epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &listenEvent);
+
+	std::vector<ServerConnection> connections;
+	epoll_event events[SERVER_MAX_EVENTS];
+
+	while (!stop.load(std::memory_order_relaxed))
+	{
+		int numEvents = epoll_wait(epoll, events, SERVER_MAX_EVENTS, SERVER_POLL_MILLISECONDS);
+		for (int i = 0; i < numEvents; i++)
+		{
+			int fd = events[i].data.fd;
+			if (fd == listener)
+			{
+				accepted.clear();
+				acceptConnections(listener, accepted);
+				for (ServerSocket socket : accepted)
+				{
+					if (static_cast<size_t>(socket) >= connections.size())
+						connections.resize(static_cast<size_t>(socket) + 1, ServerConnection{INVALID_SERVER_SOCKET, {}, {}, false});
+					connections[socket] = ServerConnection{socket, {}, {}, false};
+
+					epoll_event event = {};
+					event.events = EPOLLIN | EPOLLRDHUP;
+					event.data.fd = socket;
+					epoll_ctl(epoll, EPOLL_CTL_ADD, socket, &event);
+				}
+				continue;
+			}
+
+			ServerConnection& connection = connections[fd];
+			const uint32 watched = getWatchedEvents(connection);
+			bool open = (events[i].events & (EPOLLERR | EPOLLHUP)) == 0
+				&& ((events[i].events & (EPOLLIN | EPOLLRDHUP)) != 0 ? serviceConnection(solver, periodic, connection) : sendPendingOutput(connection));
+
+			if (!open)
+			{
+				epoll_ctl(epoll, EPOLL_CTL_DEL, fd, nullptr);
+				closeServerSocket(fd);
+				connection = ServerConnection{INVALID_SERVER_SOCKET, {}, {}, false};
+				continue;
+			}
+
+			if (getWatchedEvents(connection) != watched)
+			{
+				epoll_event event = {};
+				event.events = getWatchedEvents(connection);
+				event.data.fd = fd;
+				epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &event);
+			}
+		}
+	}
+
+	for (ServerConnection& connection : connections)
+		if (connection.socket != INVALID_SERVER_SOCKET)
+			closeServerSocket(connection.socket);
+	close(epoll);
+#else
+	// 
+	// The listener is the first entry of `sockets`, the n-th connection belongs to the (n + 1)-th entry
+	// 
+
+	std::vector<pollfd> sockets(1);
+	sockets[0].fd = listener;
+	sockets[0].events = POLLIN;
+	std::vector<ServerConnection> connections;
+
+	while (!stop.load(std::memory_order_relaxed))
+	{
+#ifdef _WIN32
+		int numEvents = WSAPoll(sockets.data(), static_cast<ULONG>(sockets.size()), SERVER_POLL_MILLISECONDS);
+#else
+		int numEvents = poll(sockets.data(), static_cast<nfds_t>(sockets.size()), SERVER_POLL_MILLISECONDS);
+#endif // _WIN32
+		if (numEvents <= 0)
+			continue;
+
+		for (size_t i = sockets.size() - 1; i > 0; i--)
+		{
+			if (sockets[i].revents == 0)
+				continue;
+
+			ServerConnection& connection = connections[i - 1];
+			bool open = (sockets[i].revents & (POLLERR | POLLNVAL)) == 0
+				&& ((sockets[i].revents & (POLLIN | POLLHUP)) != 0 ? serviceConnection(solver, periodic, connection) : sendPendingOutput(connection));
+
+			if (!open)
+			{
+				closeServerSocket(connection.socket);
+				if (i != sockets.size() - 1)
+				{
+					sockets[i] = sockets.back();
+					connection = std::move(connections.back());
+				}
+				sockets.pop_back();
+				connections.pop_back();
+				continue;
+			}
+
+			sockets[i].events = static_cast<short>((isReadingRequests(connection) ? POLLIN : 0) | (connection.output.empty() ? 0 : POLLOUT));
+		}
+
+		if ((sockets[0].revents & POLLIN) != 0)
+		{
+			accepted.clear();
+			acceptConnections(listener, accepted);
+			for (ServerSocket socket : accepted)
+			{
+				pollfd entry = {};
+				entry.fd = socket;
+				entry.events = POLLIN;
+				sockets.push_back(entry);
+				connections.push_back(ServerConnection{socket, {}, {}, false});
+			}
+		}
+	}
+
+	for (ServerConnection& connection : connections)
+		closeServerSocket(connection.socket);
+#endif // __linux__
+
+	closeServerSocket(listener);
+#ifdef _WIN32
+	WSACleanup();
+#endif // _WIN32
+	return true;
+}
@@ -0,0 +1,319 @@
+#pragma once
+
+#include "game.h"
+#include "dpsolver.h"
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
+
+/**
+ * The default path of the solution database
+ */
+static constexpr const char* SOLUTION_DB_PATH = "./solutions.db";
+
+/**
+ * Magic number at the start of every solution database file. Reads "DFDB" in a little endian file
+ */
+static constexpr uint32 SOLUTION_DB_MAGIC = 0x42444644;
+
+/**
+ * Version of the solution database format. Must be increased whenever the layout of the header, the entries or the
+ * `canonicalIndex` function changes. Databases built with another `TOTAL_BITS` are rejected by their header, databases built with
+ * a smaller `TOTAL_LIMIT` only cover their own totals
+ */
+static constexpr uint32 SOLUTION_DB_VERSION = 3;
+
+/**
+ * The header of a solution database file. It is followed by `numStates` entries, where the n-th entry corresponds to the
+ * GameStates with the canonical index n.
+ * Entries are bitmasks in the form
+ * 000AABBB, where
+ * A is the evaluation + 1 from the point of view of the active player and
+ * B is the best move or zero if the game is already over
+ */
+typedef struct _SolutionDBHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 numStates;
+	int32 minTotal;
+	int32 maxTotal;
+	uint8 totalBits;
+	uint8 reserved[3];
+} SolutionDBHeader;
+
+/**
+ * A solution database mapped into memory
+ */
+typedef struct _SolutionDB {
+	const SolutionDBHeader* header;
+	const uint8* entries;
+	void* view;
+	size_t size;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif // _WIN32
+} SolutionDB;
+
+/**
+ * The solution database used by `makeBestMove`. Nothing is looked up as long as it is not opened
+ */
+static SolutionDB solutionDB = {};
+
+/**
+ * Creates a solution database entry. See the definition of `SolutionDBHeader` for details
+ */
+static inline constexpr uint8 makeDBEntry(const int8& eval, const Move& bestMove) noexcept
+{
+	return (static_cast<uint8>(eval + 1) << 3) | bestMove;
+}
+
+/**
+ * Extracts the evaluation from a solution database entry
+ */
+static inline constexpr int8 getDBEval(const uint8& entry) noexcept
+{
+	return static_cast<int8>(entry >> 3) - 1;
+}
+
+/**
+ * Extracts the best move from a solution database entry
+ */
+static inline constexpr Move getDBMove(const uint8& entry) noexcept
+{
+	return static_cast<Move>(entry & 0b111);
+}
+
+/**
+ * Checks whether the given `GameState` is covered by the opened solution database
+ */
+static inline bool isInSolutionDB(const SolutionDB& db, const GameState& state) noexcept
+{
+	return db.entries != nullptr && state.total <= db.header->maxTotal;
+}
+
+/**
+ * Looks up the solution database entry of the given `GameState`. The state must be covered by the database
+ */
+static inline uint8 getDBEntry(const SolutionDB& db, const GameState& state) noexcept
+{
+	return db.entries[canonicalIndex(state)];
+}
+
+/**
+ * Builds the solution database entries of every state with a total in {solvedTotal + 1, ..., maxTotal} from the `values` of
+ * `solveDP` and writes them to `entries`, which must hold `NUM_CANONICAL_STATES` entries. The entries of smaller totals are left
+ * untouched. The best move of every state is the last one reaching the maximum value, just as `makeBestMove` would choose it
+ */
+static void extendSolutionEntries(uint8* entries, const int8* values, const int64& solvedTotal, const Total& maxTotal)
+{
+	for (int64 total = solvedTotal < MIN_TOTAL ? MIN_TOTAL : solvedTotal + 1; total <= maxTotal; total++)
+	{
+		for (Move lastMove = 1; lastMove <= 3; lastMove++)
+		{
+			GameState state = createGameState(lastMove, 1, static_cast<Total>(total));
+			uint32 index = canonicalIndex(state);
+
+			if (total <= 0)
+			{
+				entries[index] = makeDBEntry(values[index], 0);
+				continue;
+			}
+
+			GameState gameStates[4];
+			getPossibleStates(gameStates, state);
+
+			int8 max = -2;
+			Move bestMove = 0;
+			for (uint8 i = 0; i < 4; i++)
+			{
+				int8 val = -values[canonicalIndex(gameStates[i])];
+				if (val >= max)
+				{
+					max = val;
+					bestMove = gameStates[i].lastMove;
+				}
+			}
+
+			entries[index] = makeDBEntry(values[index], bestMove);
+		}
+	}
+}
+
+/**
+ * Builds the solution database entries of every state up to `maxTotal`, see `extendSolutionEntries`
+ */
+static void buildSolutionEntries(uint8* entries, const int8* values, const Total& maxTotal)
+{
+	extendSolutionEntries(entries, values, MIN_TOTAL - 1, maxTotal);
+}
+
+/**
+ * Restores the `values` of `solveDP` of every state up to `maxTotal` from solution database `entries`, so a solution can be
+ * extended by `extendDP` without solving it again
+ */
+static void readSolutionValues(int8* values, const uint8* entries, const Total& maxTotal)
+{
+	for (uint32 index = 0; index < getNumCanonicalStates(maxTotal); index++)
+		values[index] = getDBEval(entries[index]);
+}
+
+/**
+ * Writes a solution database with the given `entries` of every state up to `maxTotal` to `path`. Returns false if the file could
+ * not be written
+ */
+static bool writeSolutionEntries(const char* path, const uint8* entries, const Total& maxTotal)
+{
+	SolutionDBHeader header = {SOLUTION_DB_MAGIC, SOLUTION_DB_VERSION, NUM_CANONICAL_STATES, MIN_TOTAL, maxTotal, TOTAL_BITS, {0, 0, 0}};
+
+	FILE* out = fopen(path, "wb");
+	if (out == nullptr)
+		return false;
+
+	bool success = fwrite(&header, sizeof(header), 1, out) == 1
+		&& fwrite(entries, sizeof(uint8), NUM_CANONICAL_STATES, out) == NUM_CANONICAL_STATES;
+
+	return fclose(out) == 0 && success;
+}
+
+/**
+ * Unmaps the given solution database
+ */
+static void closeSolutionDB(SolutionDB& db)
+{
+	if (db.view != nullptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(db.view);
+		CloseHandle(db.mapping);
+		CloseHandle(db.file);
+#else
+		munmap(db.view, db.size);
+#endif // _WIN32
+	}
+
+	db = SolutionDB{};
+}
+
+/**
+ * Maps the solution database at `path` into memory. Returns false if the file does not exist or does not match the current
+ * format, in which case `db` stays closed
+ */
+static bool openSolutionDB(SolutionDB& db, const char* path)
+{
+	closeSolutionDB(db);
+
+	// 
+	// Map the file read-only
+	// 
+
+#ifdef _WIN32
+	db.file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (db.file == INVALID_HANDLE_VALUE)
+	{
+		db = SolutionDB{};
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(db.file, &fileSize);
+	db.size = static_cast<size_t>(fileSize.QuadPart);
+
+	db.mapping = db.size > 0 ? CreateFileMappingA(db.file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+	db.view = db.mapping != nullptr ? MapViewOfFile(db.mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (db.view == nullptr)
+	{
+		if (db.mapping != nullptr)
+			CloseHandle(db.mapping);
+		CloseHandle(db.file);
+		db = SolutionDB{};
+		return false;
+	}
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		close(fd);
+		return false;
+	}
+	db.size = static_cast<size_t>(fileStat.st_size);
+
+	void* view = mmap(nullptr, db.size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (view == MAP_FAILED)
+	{
+		db = SolutionDB{};
+		return false;
+	}
+	db.view = view;
+#endif // _WIN32
+
+	// 
+	// Validate the header
+	// 
+
+	const SolutionDBHeader* header = reinterpret_cast<const SolutionDBHeader*>(db.view);
+	if (db.size < sizeof(SolutionDBHeader)
+		|| header->magic != SOLUTION_DB_MAGIC
+		|| header->version != SOLUTION_DB_VERSION
+		|| header->numStates > NUM_CANONICAL_STATES
+		|| header->minTotal != MIN_TOTAL
+		|| header->maxTotal < MIN_TOTAL
+		|| getNumCanonicalStates(header->maxTotal) > header->numStates
+		|| header->totalBits != TOTAL_BITS
+		|| db.size < sizeof(SolutionDBHeader) + header->numStates)
+	{
+		closeSolutionDB(db);
+		return false;
+	}
+
+	db.header = header;
+	db.entries = reinterpret_cast<const uint8*>(header + 1);
+	return true;
+}
+
+/**
+ * Opens the solution database at `path`. If it cannot be opened, every game up to `maxTotal` is solved by `solveDP` and the
+ * database is written first. A database that only covers smaller totals is extended instead: its entries are kept and only the
+ * missing totals are solved by `extendDP`. Returns false if the database is not available afterwards
+ */
+static bool loadOrCreateSolutionDB(SolutionDB& db, const char* path, const Total& maxTotal)
+{
+	static int8 values[NUM_CANONICAL_STATES];
+	static uint8 entries[NUM_CANONICAL_STATES];
+
+	int64 solvedTotal = MIN_TOTAL - 1;
+	if (openSolutionDB(db, path))
+	{
+		if (db.header->maxTotal >= maxTotal)
+			return true;
+
+		solvedTotal = db.header->maxTotal;
+		memcpy(entries, db.entries, getNumCanonicalStates(solvedTotal));
+		readSolutionValues(values, entries, static_cast<Total>(solvedTotal));
+	}
+
+	extendDP(values, solvedTotal, maxTotal);
+	extendSolutionEntries(entries, values, solvedTotal, maxTotal);
+
+	closeSolutionDB(db);
+	return writeSolutionEntries(path, entries, maxTotal) && openSolutionDB(db, path);
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "game.h"
+#include "dpsolver.h"
+#include "solutiondb.h"
+#include <algorithm>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+/**
+ * The answer of a `Solver` to a single query of `queryBatch`
+ */
+typedef struct _QueryResult {
+	int8 eval;
+	Move bestMove;
+} QueryResult;
+
+/**
+ * The smallest number of queries `Solver::queryBatch` hands to a thread. Smaller batches are not worth starting a thread for
+ */
+static constexpr size_t MIN_QUERIES_PER_THREAD = 1 << 14;
+
+/**
+ * A solved game for embedding the bot into other programs. A Solver owns the evaluation and best move of every GameState up to
+ * its maximum total, either solved by `solveDP` or mapped from a solution database file. It uses none of the global tables of the
+ * search. Once solved or loaded a Solver is never modified by a query, so any number of threads may query it at the same time
+ * without locking.
+ */
+class Solver
+{
+public:
+	/**
+	 * Creates a Solver without a solution. It covers no GameState until `solve` or `load` is called
+	 */
+	Solver() noexcept : entries(nullptr), maxTotal(0), db{}
+	{
+	}
+
+	Solver(const Solver&) = delete;
+	Solver& operator=(const Solver&) = delete;
+
+	~Solver()
+	{
+		closeSolutionDB(db);
+	}
+
+	/**
+	 * Solves every GameState up to `maxTotal` with `solveDP`. Must not be called while other threads query the Solver
+	 */
+	void solve(const Total& maxTotal)
+	{
+		closeSolutionDB(db);
+
+		std::vector<int8> values(NUM_CANONICAL_STATES);
+		solveDP(values.data(), maxTotal);
+
+		ownedEntries.assign(NUM_CANONICAL_STATES, 0);
+		buildSolutionEntries(ownedEntries.data(), values.data(), maxTotal);
+
+		entries = ownedEntries.data();
+		this->maxTotal = maxTotal;
+	}
+
+	/**
+	 * Extends the solution to every GameState up to `maxTotal`, only the totals above the current maximum are solved by `extendDP`.
+	 * A loaded database is copied into the Solver first, so `save` can write the extended solution back. Does nothing if the
+	 * solution already covers `maxTotal`. Must not be called while other threads query the Solver
+	 */
+	void extend(const Total& maxTotal)
+	{
+		if (entries == nullptr)
+		{
+			solve(maxTotal);
+			return;
+		}
+
+		if (maxTotal <= this->maxTotal)
+			return;
+
+		if (entries != ownedEntries.data())
+		{
+			ownedEntries.assign(NUM_CANONICAL_STATES, 0);
+			memcpy(ownedEntries.data(), entries, getNumCanonicalStates(this->maxTotal));
+			closeSolutionDB(db);
+		}
+
+		std::vector<int8> values(NUM_CANONICAL_STATES);
+		readSolutionValues(values.data(), ownedEntries.data(), this->maxTotal);
+		extendDP(values.data(), this->maxTotal, maxTotal);
+		extendSolutionEntries(ownedEntries.data(), values.data(), this->maxTotal, maxTotal);
+
+		entries = ownedEntries.data();
+		this->maxTotal = maxTotal;
+	}
+
+	/**
+	 * Maps the solution database at `path` into memory instead of solving. Returns false if it cannot be opened, in which case the
+	 * Solver covers no GameState. Must not be called while other threads query the Solver
+	 */
+	bool load(const char* path)
+	{
+		ownedEntries.clear();
+		entries = nullptr;
+		maxTotal = 0;
+
+		if (!openSolutionDB(db, path))
+			return false;
+
+		entries = db.entries;
+		maxTotal = static_cast<Total>(db.header->maxTotal);
+		return true;
+	}
+
+	/**
+	 * Writes the solution to a solution database at `path`, so later runs can `load` it. Returns false if there is no solution or
+	 * the file could not be written
+	 */
+	bool save(const char* path) const
+	{
+		return entries != nullptr && writeSolutionEntries(path, entries, maxTotal);
+	}
+
+	/**
+	 * Returns the largest total covered by the solution
+	 */
+	Total getMaxTotal() const noexcept
+	{
+		return maxTotal;
+	}
+
+	/**
+	 * Checks whether the given `GameState` is covered by the solution. Only covered states may be passed to the queries below
+	 */
+	bool covers(const GameState& state) const noexcept
+	{
+		return entries != nullptr && state.total <= maxTotal;
+	}
+
+	/**
+	 * Returns the evaluation of the given `GameState` from the point of view of its active player
+	 */
+	int8 evaluate(const GameState& state) const noexcept
+	{
+		return getDBEval(entries[canonicalIndex(state)]);
+	}
+
+	/**
+	 * Returns the best move of the given `GameState` or zero if the game is already over
+	 */
+	Move bestMove(const GameState& state) const noexcept
+	{
+		return getDBMove(entries[canonicalIndex(state)]);
+	}
+
+	/**
+	 * Performs the best move on the given `GameState`, just like `makeBestMove`. The game must not be over yet
+	 */
+	GameState makeBestMove(const GameState& state) const noexcept
+	{
+		return performMove(state, bestMove(state));
+	}
+
+	/**
+	 * Answers `count` queries at once and writes the evaluation and best move of `states[i]` to `results[i]`. States that are not
+	 * covered by the solution get an evaluation and best move of zero, which no solved state has. Every query is a single read of
+	 * the solution without any dependency on the others, so the CPU overlaps their cache misses best in the given order, grouping
+	 * them by total is slower. Large batches are split into contiguous ranges that are answered on up to `numThreads` threads
+	 */
+	void queryBatch(const GameState* states, const size_t& count, QueryResult* results, const unsigned& numThreads = 1) const
+	{
+		size_t threads = std::max<size_t>(1, std::min<size_t>(numThreads, count / MIN_QUERIES_PER_THREAD));
+		size_t chunk = (count + threads - 1) / threads;
+
+		std::vector<std::thread> workers;
+		for (size_t t = 1; t < threads; t++)
+			workers.emplace_back(&Solver::answerQueries, this, states, t * chunk, std::min(count, (t + 1) * chunk), results);
+
+		answerQueries(states, 0, std::min(count, chunk), results);
+
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+private:
+	/**
+	 * Answers the queries `begin` up to `end` of `queryBatch`
+	 */
+	void answerQueries(const GameState* states, const size_t& begin, const size_t& end, QueryResult* results) const noexcept
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			if (!covers(states[i]))
+			{
+				results[i] = QueryResult{0, 0};
+				continue;
+			}
+
+			uint8 entry = entries[canonicalIndex(states[i])];
+			results[i] = QueryResult{getDBEval(entry), getDBMove(entry)};
+		}
+	}
+
+	std::vector<uint8> ownedEntries;
+	const uint8* entries;
+	Total maxTotal;
+	SolutionDB db;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "config.h"
+#include "types.h"
+#include <string>
+#include <stdio.h>
+
+/**
+ * Counters describing the work done by the search
+ */
+typedef struct _SearchStats {
+	uint64 nodes;
+	uint64 ttProbes;
+	uint64 ttHitsExact;
+	uint64 ttHitsLower;
+	uint64 ttHitsUpper;
+	uint64 betaCutoffs;
+	uint64 researches;
+	uint64 ttStores;
+	uint64 ttOverwrites;
+	uint64 bestMoveCalls;
+	uint64 bestMoveLookups;
+} SearchStats;
+
+#ifdef SEARCH_STATS
+/**
+ * The counters of the calling thread. They only exist if `SEARCH_STATS` is defined, see `getSearchStats`
+ */
+static thread_local SearchStats searchStats = {};
+#endif // SEARCH_STATS
+
+/**
+ * Increments the counter `name` of `searchStats`. Compiles to nothing if `SEARCH_STATS` is not defined
+ */
+#ifdef SEARCH_STATS
+#define COUNT_STAT(name) (searchStats.name++)
+#else
+#define COUNT_STAT(name) ((void)0)
+#endif // SEARCH_STATS
+
+/**
+ * Returns the counters of the calling thread, which are all zero if `SEARCH_STATS` is not defined
+ */
+static inline SearchStats getSearchStats() noexcept
+{
+#ifdef SEARCH_STATS
+	return searchStats;
+#else
+	return SearchStats();
+#endif // SEARCH_STATS
+}
+
+/**
+ * Adds the counters of `from` to `into`
+ */
+static inline void mergeSearchStats(SearchStats& into, const SearchStats& from) noexcept
+{
+	into.nodes += from.nodes;
+	into.ttProbes += from.ttProbes;
+	into.ttHitsExact += from.ttHitsExact;
+	into.ttHitsLower += from.ttHitsLower;
+	into.ttHitsUpper += from.ttHitsUpper;
+	into.betaCutoffs += from.betaCutoffs;
+	into.researches += from.researches;
+	into.ttStores += from.ttStores;
+	into.ttOverwrites += from.ttOverwrites;
+	into.bestMoveCalls += from.bestMoveCalls;
+	into.bestMoveLookups += from.bestMoveLookups;
+}
+
+/**
+ * Returns the counters of `later` minus the counters of `earlier`
+ */
+static inline SearchStats subtractSearchStats(const SearchStats& later, const SearchStats& earlier) noexcept
+{
+	SearchStats out;
+	out.nodes = later.nodes - earlier.nodes;
+	out.ttProbes = later.ttProbes - earlier.ttProbes;
+	out.ttHitsExact = later.ttHitsExact - earlier.ttHitsExact;
+	out.ttHitsLower = later.ttHitsLower - earlier.ttHitsLower;
+	out.ttHitsUpper = later.ttHitsUpper - earlier.ttHitsUpper;
+	out.betaCutoffs = later.betaCutoffs - earlier.betaCutoffs;
+	out.researches = later.researches - earlier.researches;
+	out.ttStores = later.ttStores - earlier.ttStores;
+	out.ttOverwrites = later.ttOverwrites - earlier.ttOverwrites;
+	out.bestMoveCalls = later.bestMoveCalls - earlier.bestMoveCalls;
+	out.bestMoveLookups = later.bestMoveLookups - earlier.bestMoveLookups;
+	return out;
+}
+
+/**
+ * Formats the counters of `stats` as a single line. `seconds` is the time the counted work took and is used for the node rate
+ */
+static inline std::string formatSearchStats(const SearchStats& stats, const double& seconds)
+{
+	uint64 ttHits = stats.ttHitsExact + stats.ttHitsLower + stats.ttHitsUpper;
+	double hitRate = stats.ttProbes > 0 ? 100.0 * ttHits / stats.ttProbes : 0.0;
+	double nodesPerSecond = seconds > 0 ? stats.nodes / seconds : 0.0;
+
+	char line[512];
+	snprintf(line, sizeof(line),
+		"nodes: %llu, nodes/s: %.0f, tt probes: %llu, tt hits: %llu (%.1f%%, exact %llu, lower %llu, upper %llu), beta cutoffs: %llu, "
+		"re-searches: %llu, tt stores: %llu (overwrites %llu), best moves: %llu (looked up %llu)",
+		static_cast<unsigned long long>(stats.nodes), nodesPerSecond,
+		static_cast<unsigned long long>(stats.ttProbes), static_cast<unsigned long long>(ttHits), hitRate,
+		static_cast<unsigned long long>(stats.ttHitsExact), static_cast<unsigned long long>(stats.ttHitsLower),
+		static_cast<unsigned long long>(stats.ttHitsUpper), static_cast<unsigned long long>(stats.betaCutoffs),
+		static_cast<unsigned long long>(stats.researches),
+		static_cast<unsigned long long>(stats.ttStores), static_cast<unsigned long long>(stats.ttOverwrites),
+		static_cast<unsigned long long>(stats.bestMoveCalls), static_cast<unsigned long long>(stats.bestMoveLookups));
+
+	return line;
+}
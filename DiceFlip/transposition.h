@@ -0,0 +1,512 @@
+#pragma once
+
+#include "config.h"
+#include "game.h"
+#include "stats.h"
+#include "ttmemory.h"
+
+#ifdef SHARED_TT
+#include <atomic>
+#endif // SHARED_TT
+
+/**
+ * The datatype representing a node type used for alpha-beta-pruning.
+ * 1: EXACT
+ * 2: LOWER
+ * 3: UPPER
+ */
+typedef uint8 NodeType;
+
+/**
+ * Constant representing the EXACT node type
+ */
+static constexpr NodeType NODE_TYPE_EXACT = 1;
+
+/**
+ * Constant representing the LOWER node type
+ */
+static constexpr NodeType NODE_TYPE_LOWER = 2;
+
+/**
+ * Constant representing the UPPER node type
+ */
+static constexpr NodeType NODE_TYPE_UPPER = 3;
+
+/**
+ * The transposition table used to avoid unnecessary calculations.
+ * The n-th entry in the table corresponds to the GameStates with the canonical index n. Those states are equivalent under the
+ * symmetries of the game, so every entry serves all of them, see `canonicalIndex`.
+ * Values of the transposition table are bitmasks in the form
+ * AAAAAAAABBMMMCCC, where
+ * A is the evaluation depth of the entry
+ * B is the node type
+ * M is the best move found for the GameState or zero if there is none and
+ * C is the evaluation as a 3 bit two's complement number
+ * An entry belongs to the GameState it is stored for. It holds the fail-soft value of a search of that state with at least the
+ * stored depth, which is exact, a lower bound or an upper bound as given by the node type. See `probeTTEntry` and `storeTTResult`.
+ * Every thread owns its own table, so searches running on different threads never race on the entries. If `SHARED_TT` is
+ * defined, all threads share a single table of packed words instead, see `makeSharedTTWord`.
+ * The table is a single block of `NUM_CANONICAL_STATES` words, whose pages the OS only backs once they are touched. If
+ * `SEGMENTED_TT` is defined, it is an array of pointers to segments of `TT_SEGMENT_ENTRIES` words instead, which are allocated
+ * on their first store. A missing segment reads as empty. If `BUCKET_TT` is defined, it is a bounded array of `TTBucket`s instead.
+ */
+#if defined(BUCKET_TT) && defined(SEGMENTED_TT)
+#error "BUCKET_TT cannot be combined with SEGMENTED_TT"
+#endif // BUCKET_TT && SEGMENTED_TT
+
+#ifdef BUCKET_TT
+#ifdef SHARED_TT
+typedef std::atomic<uint64> TTWord;
+#else
+typedef uint64 TTWord;
+#endif // SHARED_TT
+#else
+#ifdef SHARED_TT
+typedef std::atomic<uint32> TTWord;
+#else
+typedef uint16 TTWord;
+#endif // SHARED_TT
+#endif // BUCKET_TT
+
+#if defined(BUCKET_TT)
+/**
+ * The number of slots of a `TTBucket`
+ */
+static constexpr uint8 TT_BUCKET_SLOTS = 8;
+
+/**
+ * The number of depth-preferred slots at the start of a `TTBucket`, the others are always replaced
+ */
+static constexpr uint8 TT_DEPTH_SLOTS = 4;
+
+/**
+ * A bucket of the transposition table, filling exactly one cache line, so a probe only ever touches a single one.
+ * Every slot is a word in the form
+ * KKKKKKKKKKKKKKKKKKKKKKKKKKKKKKKK0000000000000000EEEEEEEEEEEEEEEE, where
+ * K is the canonical index of the entry's GameStates and
+ * E is the entry, zero for an empty slot
+ * Key and entry are read and written at once, so even a shared table needs no further verification. The first
+ * `TT_DEPTH_SLOTS` slots keep the deepest entries, an entry that is pushed out of them moves to the always replaced slots, see
+ * `storeTTEntry`
+ */
+typedef struct alignas(64) _TTBucket {
+	TTWord slots[TT_BUCKET_SLOTS];
+} TTBucket;
+
+static_assert(sizeof(TTBucket) == 64, "A TTBucket must fill exactly one cache line");
+
+/**
+ * The number of buckets of a `BUCKET_TT`. A table for every canonical index would hold `TT_DEPTH_SLOTS` entries per bucket, so it
+ * is never larger than that
+ */
+static constexpr uint64 NUM_TT_BUCKETS = (static_cast<uint64>(TT_SIZE_MB) << 20) / sizeof(TTBucket)
+	< (static_cast<uint64>(NUM_CANONICAL_STATES) + TT_DEPTH_SLOTS - 1) / TT_DEPTH_SLOTS
+	? (static_cast<uint64>(TT_SIZE_MB) << 20) / sizeof(TTBucket)
+	: (static_cast<uint64>(NUM_CANONICAL_STATES) + TT_DEPTH_SLOTS - 1) / TT_DEPTH_SLOTS;
+
+static_assert(NUM_TT_BUCKETS > 0, "TT_SIZE_MB must be positive");
+
+#ifdef SHARED_TT
+static TTBucket* transpositionTable = nullptr;
+#else
+static thread_local TTBucket* transpositionTable = nullptr;
+#endif // SHARED_TT
+#elif defined(SEGMENTED_TT)
+#ifdef SHARED_TT
+typedef std::atomic<TTWord*> TTSegment;
+static TTSegment* transpositionTable = nullptr;
+#else
+typedef TTWord* TTSegment;
+static thread_local TTSegment* transpositionTable = nullptr;
+#endif // SHARED_TT
+
+/**
+ * The size of a segment of a `SEGMENTED_TT`. Huge page backed segments span a whole huge page
+ */
+#ifdef HUGE_PAGE_TT
+static constexpr size_t TT_SEGMENT_BYTES = HUGE_PAGE_BYTES;
+#else
+static constexpr size_t TT_SEGMENT_BYTES = 16384;
+#endif // HUGE_PAGE_TT
+
+/**
+ * The number of entries of a segment, a power of two so splitting an index into segment and entry compiles to shifts
+ */
+static constexpr uint32 TT_SEGMENT_ENTRIES = static_cast<uint32>(TT_SEGMENT_BYTES / sizeof(TTWord));
+static_assert((TT_SEGMENT_ENTRIES & (TT_SEGMENT_ENTRIES - 1)) == 0, "TT_SEGMENT_ENTRIES must be a power of two");
+
+/**
+ * The number of segments covering every canonical index
+ */
+static constexpr uint32 NUM_TT_SEGMENTS = (NUM_CANONICAL_STATES + TT_SEGMENT_ENTRIES - 1) / TT_SEGMENT_ENTRIES;
+#else
+#ifdef SHARED_TT
+static TTWord* transpositionTable = nullptr;
+#else
+static thread_local TTWord* transpositionTable = nullptr;
+#endif // SHARED_TT
+#endif // SEGMENTED_TT
+
+static_assert(sizeof(TTWord) == sizeof(uint16) || sizeof(TTWord) == sizeof(uint32) || sizeof(TTWord) == sizeof(uint64),
+	"Zeroed memory must be an empty TTWord");
+
+/**
+ * The depth stored for entries whose evaluation holds for every search depth
+ */
+static constexpr uint8 PROVEN_DEPTH = 0xFF;
+
+/**
+ * Allocates an empty transposition table for the calling thread. If `SHARED_TT` is defined, the table is shared by all threads
+ * and must be allocated once before any search starts
+ */
+static void allocateTranspositionTable()
+{
+#if defined(BUCKET_TT)
+	transpositionTable = reinterpret_cast<TTBucket*>(allocateTTMemory(sizeof(TTBucket) * NUM_TT_BUCKETS));
+#elif defined(SEGMENTED_TT)
+	transpositionTable = new TTSegment[NUM_TT_SEGMENTS]();
+#else
+	transpositionTable = reinterpret_cast<TTWord*>(allocateTTMemory(sizeof(TTWord) * NUM_CANONICAL_STATES));
+#endif // SEGMENTED_TT
+}
+
+/**
+ * Frees the transposition table allocated by `allocateTranspositionTable`
+ */
+static void freeTranspositionTable()
+{
+#if defined(BUCKET_TT)
+	freeTTMemory(transpositionTable, sizeof(TTBucket) * NUM_TT_BUCKETS);
+#elif defined(SEGMENTED_TT)
+	for (uint32 segment = 0; segment < NUM_TT_SEGMENTS; segment++)
+#ifdef SHARED_TT
+		freeTTMemory(transpositionTable[segment].load(std::memory_order_relaxed), TT_SEGMENT_BYTES);
+#else
+		freeTTMemory(transpositionTable[segment], TT_SEGMENT_BYTES);
+#endif // SHARED_TT
+	delete[] transpositionTable;
+#else
+	freeTTMemory(transpositionTable, sizeof(TTWord) * NUM_CANONICAL_STATES);
+#endif // SEGMENTED_TT
+	transpositionTable = nullptr;
+}
+
+#ifdef SEGMENTED_TT
+/**
+ * Returns the segment of the transposition table holding the canonical index `index`, or nullptr if nothing was stored in it yet
+ */
+static inline TTWord* findTTSegment(const uint32& index) noexcept
+{
+#ifdef SHARED_TT
+	return transpositionTable[index / TT_SEGMENT_ENTRIES].load(std::memory_order_acquire);
+#else
+	return transpositionTable[index / TT_SEGMENT_ENTRIES];
+#endif // SHARED_TT
+}
+
+/**
+ * Returns the segment of the transposition table holding the canonical index `index` and allocates it if it is missing. If
+ * another thread allocates the same segment of a shared table at the same time, the first one wins and the other is freed again.
+ * Returns nullptr if the segment cannot be allocated
+ */
+static TTWord* getTTSegment(const uint32& index) noexcept
+{
+	TTWord* segment = findTTSegment(index);
+	if (segment != nullptr)
+		return segment;
+
+	segment = reinterpret_cast<TTWord*>(allocateTTMemory(TT_SEGMENT_BYTES));
+
+#ifdef SHARED_TT
+	TTWord* expected = nullptr;
+	if (segment != nullptr
+		&& !transpositionTable[index / TT_SEGMENT_ENTRIES].compare_exchange_strong(expected, segment, std::memory_order_acq_rel))
+	{
+		freeTTMemory(segment, TT_SEGMENT_BYTES);
+		return expected;
+	}
+#else
+	transpositionTable[index / TT_SEGMENT_ENTRIES] = segment;
+#endif // SHARED_TT
+
+	return segment;
+}
+#endif // SEGMENTED_TT
+
+/**
+ * Creates a transposition table entry value. See the definition of `transpositionTable` for details
+ */
+static inline constexpr uint16 makeTTVal(const uint8& depth, const int8& eval, const NodeType& type, const Move& bestMove = 0)
+{
+	return (static_cast<uint16>(depth) << 8)
+		| (static_cast<NodeType>(type) << 6)
+		| (static_cast<uint16>(bestMove) << 3)
+		| (static_cast<uint8>(eval) & 0b111);
+}
+
+/**
+ * Extracts the depth value from a transposition table entry
+ */
+static inline constexpr uint8 getDepth(const uint16& entry) noexcept
+{
+	return entry >> 8;
+}
+
+/**
+ * Extracts the evaluation value from a transposition table entry
+ */
+static inline constexpr int8 getRating(const uint16& entry) noexcept
+{
+	return static_cast<int8>((entry & 0b111) ^ 0b100) - 0b100;
+}
+
+/**
+ * Extracts the best move from a transposition table entry. Returns zero if the entry does not know a best move
+ */
+static inline constexpr Move getBestMove(const uint16& entry) noexcept
+{
+	return static_cast<Move>((entry >> 3) & 0b111);
+}
+
+/**
+ * Extracts the node type from a transposition table entry
+ */
+static inline constexpr NodeType getNodeType(const uint16& entry) noexcept
+{
+	return static_cast<NodeType>((entry >> 6) & 0b11);
+}
+
+#ifdef SHARED_TT
+/**
+ * Computes the 16 bit verification key of the GameStates with the canonical index `index`. The key is never zero, so an empty word
+ * never verifies
+ */
+static inline constexpr uint16 makeTTKey(const uint32& index) noexcept
+{
+	return static_cast<uint16>((index * 0x9E3779B1u) >> 16) | 1;
+}
+
+/**
+ * Packs a transposition table entry into a word of the shared table. Words are bitmasks in the form
+ * KKKKKKKKKKKKKKKKEEEEEEEEEEEEEEEE, where
+ * E is the entry and
+ * K is the verification key of the entry's GameState XORed with E
+ * Depth, node type and evaluation are read and written with a single atomic access, so a reader either sees a complete entry or
+ * rejects the word. With the dense `canonicalIndex` a wrong key can only come from an empty word, but the check keeps the entries
+ * self-validating if the table is ever folded into a smaller range.
+ */
+static inline constexpr uint32 makeSharedTTWord(const uint32& index, const uint16& entry) noexcept
+{
+	return (static_cast<uint32>(makeTTKey(index) ^ entry) << 16) | entry;
+}
+#endif // SHARED_TT
+
+#ifdef BUCKET_TT
+/**
+ * Returns the bucket of the GameStates with the canonical index `index`. Neighbouring indices share a bucket, so the states of
+ * neighbouring totals stay in neighbouring cache lines, and indices `TT_DEPTH_SLOTS * NUM_TT_BUCKETS` apart compete for one
+ */
+static inline TTBucket& getTTBucket(const uint32& index) noexcept
+{
+	return transpositionTable[(index / TT_DEPTH_SLOTS) % NUM_TT_BUCKETS];
+}
+
+/**
+ * Reads a slot of a `TTBucket`
+ */
+static inline uint64 readTTSlot(const TTWord& slot) noexcept
+{
+#ifdef SHARED_TT
+	return slot.load(std::memory_order_relaxed);
+#else
+	return slot;
+#endif // SHARED_TT
+}
+
+/**
+ * Overwrites a slot of a `TTBucket` with the entry `entry` of the GameStates with the canonical index `index`
+ */
+static inline void writeTTSlot(TTWord& slot, const uint32& index, const uint16& entry) noexcept
+{
+#ifdef SHARED_TT
+	slot.store((static_cast<uint64>(index) << 32) | entry, std::memory_order_relaxed);
+#else
+	slot = (static_cast<uint64>(index) << 32) | entry;
+#endif // SHARED_TT
+}
+
+/**
+ * Reads the transposition table entry of the GameStates with the canonical index `index` from its bucket. Returns zero if the
+ * bucket holds no entry of these states
+ */
+static inline uint16 loadTTEntry(const uint32& index) noexcept
+{
+	const TTBucket& bucket = getTTBucket(index);
+	for (uint8 i = 0; i < TT_BUCKET_SLOTS; i++)
+	{
+		uint64 word = readTTSlot(bucket.slots[i]);
+		if (static_cast<uint32>(word >> 32) == index && static_cast<uint16>(word) != 0)
+			return static_cast<uint16>(word);
+	}
+
+	return 0;
+}
+
+/**
+ * Stores the transposition table entry of the GameStates with the canonical index `index` into its bucket. An entry of the same
+ * states is overwritten. Otherwise the entry takes the depth-preferred slot of the shallowest entry if it is searched at least as
+ * deep, and that entry moves on to the always replaced slots. Failing that, the entry goes to the always replaced slots itself,
+ * where the canonical index picks the slot
+ */
+static inline void storeTTEntry(const uint32& index, const uint16& entry) noexcept
+{
+	TTBucket& bucket = getTTBucket(index);
+
+	uint8 victim = 0;
+	uint64 victimWord = readTTSlot(bucket.slots[0]);
+	for (uint8 i = 0; i < TT_BUCKET_SLOTS; i++)
+	{
+		uint64 word = readTTSlot(bucket.slots[i]);
+		if (static_cast<uint32>(word >> 32) == index && static_cast<uint16>(word) != 0)
+		{
+			writeTTSlot(bucket.slots[i], index, entry);
+			return;
+		}
+
+		if (i < TT_DEPTH_SLOTS && static_cast<uint16>(victimWord) != 0
+			&& (static_cast<uint16>(word) == 0 || getDepth(static_cast<uint16>(word)) < getDepth(static_cast<uint16>(victimWord))))
+		{
+			victim = i;
+			victimWord = word;
+		}
+	}
+
+	uint32 alwaysIndex = index;
+	uint16 alwaysEntry = entry;
+
+	if (static_cast<uint16>(victimWord) == 0 || getDepth(static_cast<uint16>(victimWord)) <= getDepth(entry))
+	{
+		writeTTSlot(bucket.slots[victim], index, entry);
+		if (static_cast<uint16>(victimWord) == 0)
+			return;
+
+		alwaysIndex = static_cast<uint32>(victimWord >> 32);
+		alwaysEntry = static_cast<uint16>(victimWord);
+	}
+
+	writeTTSlot(bucket.slots[TT_DEPTH_SLOTS + alwaysIndex % (TT_BUCKET_SLOTS - TT_DEPTH_SLOTS)], alwaysIndex, alwaysEntry);
+}
+#else
+/**
+ * Reads the transposition table entry of the GameStates with the canonical index `index`. The entry is read at once, so all values
+ * extracted from it belong together. Returns zero if there is no entry yet
+ */
+static inline uint16 loadTTEntry(const uint32& index) noexcept
+{
+#ifdef SEGMENTED_TT
+	const TTWord* segment = findTTSegment(index);
+	if (segment == nullptr)
+		return 0;
+
+	const TTWord& slot = segment[index % TT_SEGMENT_ENTRIES];
+#else
+	const TTWord& slot = transpositionTable[index];
+#endif // SEGMENTED_TT
+
+#ifdef SHARED_TT
+	uint32 word = slot.load(std::memory_order_relaxed);
+	uint16 entry = static_cast<uint16>(word);
+	return static_cast<uint16>(word >> 16) == (makeTTKey(index) ^ entry) ? entry : 0;
+#else
+	return slot;
+#endif // SHARED_TT
+}
+
+/**
+ * Overwrites the transposition table entry of the GameStates with the canonical index `index`. If the segment of the entry cannot
+ * be allocated, the entry is dropped, which only costs the search the time to find it again
+ */
+static inline void storeTTEntry(const uint32& index, const uint16& entry) noexcept
+{
+#ifdef SEGMENTED_TT
+	TTWord* segment = getTTSegment(index);
+	if (segment == nullptr)
+		return;
+
+	TTWord& slot = segment[index % TT_SEGMENT_ENTRIES];
+#else
+	TTWord& slot = transpositionTable[index];
+#endif // SEGMENTED_TT
+
+#ifdef SHARED_TT
+	slot.store(makeSharedTTWord(index, entry), std::memory_order_relaxed);
+#else
+	slot = entry;
+#endif // SHARED_TT
+}
+#endif // BUCKET_TT
+
+/**
+ * Probes the transposition table `entry` of a GameState that is about to be searched with a maximum depth of `depth` and the window
+ * (`alpha`, `beta`). Bounds of the entry narrow the window. Returns true if the entry decides the search, in which case its
+ * fail-soft value is written to `value`
+ */
+static inline bool probeTTEntry(const uint16& entry, const uint8& depth, int8& alpha, int8& beta, int8& value) noexcept
+{
+	COUNT_STAT(ttProbes);
+	if (getDepth(entry) < depth)
+		return false;
+
+	value = getRating(entry);
+
+	switch (getNodeType(entry))
+	{
+	case NODE_TYPE_LOWER:
+	{
+		COUNT_STAT(ttHitsLower);
+		if (value > alpha)
+			alpha = value;
+	} break;
+	case NODE_TYPE_UPPER:
+	{
+		COUNT_STAT(ttHitsUpper);
+		if (value < beta)
+			beta = value;
+	} break;
+	case NODE_TYPE_EXACT:
+	{
+		COUNT_STAT(ttHitsExact);
+		return true;
+	}
+	}
+
+	if (alpha >= beta)
+	{
+		COUNT_STAT(betaCutoffs);
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Stores the fail-soft `value` of a search of the GameStates with the canonical index `index`. `depth` is the maximum depth and
+ * (`alpha`, `beta`) the window the state was searched with after `probeTTEntry`, `previous` is the entry that was probed.
+ * Only draws at the maximum depth depend on it, wins and losses are proven by terminal states and are stored with `PROVEN_DEPTH`
+ */
+static inline void storeTTResult(const uint32& index, const uint16& previous, const uint8& depth, const int8& value, const int8& alpha,
+	const int8& beta, const Move& bestMove) noexcept
+{
+	COUNT_STAT(ttStores);
+	if (previous != 0)
+		COUNT_STAT(ttOverwrites);
+
+	const uint8 ttDepth = value != 0 ? PROVEN_DEPTH : depth;
+
+	if (value <= alpha)
+		storeTTEntry(index, makeTTVal(ttDepth, value, NODE_TYPE_UPPER, bestMove));
+	else if (value >= beta)
+		storeTTEntry(index, makeTTVal(ttDepth, value, NODE_TYPE_LOWER, bestMove));
+	else
+		storeTTEntry(index, makeTTVal(ttDepth, value, NODE_TYPE_EXACT, bestMove));
+}
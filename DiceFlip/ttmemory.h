@@ -0,0 +1,91 @@
+#pragma once
+
+#include "config.h"
+#include "types.h"
+#include <stddef.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif // WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif // NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif // _WIN32
+
+/**
+ * The size of a huge page. Memory for the transposition table is allocated in multiples of it if `HUGE_PAGE_TT` is defined
+ */
+static constexpr size_t HUGE_PAGE_BYTES = static_cast<size_t>(1) << 21;
+
+/**
+ * Returns the number of bytes `allocateTTMemory` actually maps for a request of `bytes`
+ */
+static inline constexpr size_t getTTMemorySize(const size_t& bytes) noexcept
+{
+#ifdef HUGE_PAGE_TT
+	return (bytes + HUGE_PAGE_BYTES - 1) / HUGE_PAGE_BYTES * HUGE_PAGE_BYTES;
+#else
+	return bytes;
+#endif // HUGE_PAGE_TT
+}
+
+/**
+ * Allocates `bytes` of zeroed memory for the transposition table directly from the OS. The memory is page aligned and only backed
+ * by physical pages once it is touched, so untouched parts of a table cost nothing. If `HUGE_PAGE_TT` is defined, huge pages are
+ * requested, which are used if the OS has reserved some (`MAP_HUGETLB`, or `MEM_LARGE_PAGES` with the lock pages privilege on
+ * Windows). Otherwise Linux is asked to back the memory with transparent huge pages. Returns nullptr if the allocation fails
+ */
+static void* allocateTTMemory(const size_t& bytes) noexcept
+{
+	const size_t size = getTTMemorySize(bytes);
+
+#ifdef _WIN32
+#ifdef HUGE_PAGE_TT
+	SIZE_T largePage = GetLargePageMinimum();
+	if (largePage != 0 && size % largePage == 0)
+	{
+		void* memory = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+		if (memory != nullptr)
+			return memory;
+	}
+#endif // HUGE_PAGE_TT
+
+	return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+#if defined(HUGE_PAGE_TT) && defined(MAP_HUGETLB)
+	void* huge = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (huge != MAP_FAILED)
+		return huge;
+#endif // HUGE_PAGE_TT && MAP_HUGETLB
+
+	void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+		return nullptr;
+
+#if defined(HUGE_PAGE_TT) && defined(MADV_HUGEPAGE)
+	madvise(memory, size, MADV_HUGEPAGE);
+#endif // HUGE_PAGE_TT && MADV_HUGEPAGE
+
+	return memory;
+#endif // _WIN32
+}
+
+/**
+ * Frees the `bytes` of memory allocated by `allocateTTMemory`
+ */
+static void freeTTMemory(void* memory, const size_t& bytes) noexcept
+{
+	if (memory == nullptr)
+		return;
+
+#ifdef _WIN32
+	(void)bytes;
+	VirtualFree(memory, 0, MEM_RELEASE);
+#else
+	munmap(memory, getTTMemorySize(bytes));
+#endif // _WIN32
+}
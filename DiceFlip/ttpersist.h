@@ -0,0 +1,217 @@
+#pragma once
+
+#include "game.h"
+#include "transposition.h"
+#include "checksum.h"
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+/**
+ * The default path of a saved transposition table
+ */
+static constexpr const char* TT_FILE_PATH = "./transposition.tt";
+
+/**
+ * Magic number at the start of every saved transposition table. Reads "DFTT" in a little endian file
+ */
+static constexpr uint32 TT_FILE_MAGIC = 0x54544644;
+
+/**
+ * Version of the saved transposition table format. Must be increased whenever the layout of the header, the runs, the entries of
+ * `transpositionTable` or the `canonicalIndex` function changes. Tables saved with another `TOTAL_BITS` are rejected by their
+ * header, tables saved with a smaller `TOTAL_LIMIT` only fill their own totals
+ */
+static constexpr uint32 TT_FILE_VERSION = 1;
+
+/**
+ * The header of a saved transposition table. It is followed by `numRuns` runs of consecutive non-empty entries. Every run is the
+ * uint32 canonical index of its first entry, the uint32 number of its entries and the uint16 entries themselves, in the layout
+ * described at `transpositionTable`. `checksum` is the FNV-1a hash of the header, with a zero checksum, and all runs
+ */
+typedef struct _TTFileHeader {
+	uint32 magic;
+	uint32 version;
+	uint32 numStates;
+	int32 minTotal;
+	int32 maxTotal;
+	uint8 totalBits;
+	uint8 entryBytes;
+	uint8 reserved[2];
+	uint32 numRuns;
+	uint32 numEntries;
+	uint64 checksum;
+} TTFileHeader;
+
+static_assert(sizeof(TTFileHeader) == 40, "TTFileHeader must not contain padding, it is hashed as a whole");
+
+/**
+ * A copy of the entries of one or more transposition tables, indexed by the canonical index. It is empty until the first entry
+ * is merged into it, otherwise it holds `NUM_CANONICAL_STATES` entries
+ */
+typedef std::vector<uint16> TTSnapshot;
+
+/**
+ * Merges the transposition table of the calling thread, or the shared one if `SHARED_TT` is defined, into `snapshot`. Of two
+ * entries of the same state the one searched deeper is kept, proven entries hold for every depth and always win
+ */
+static void mergeTTSnapshot(TTSnapshot& snapshot)
+{
+	if (snapshot.empty())
+		snapshot.assign(NUM_CANONICAL_STATES, 0);
+
+	for (uint32 index = 0; index < NUM_CANONICAL_STATES; index++)
+	{
+		uint16 entry = loadTTEntry(index);
+		if (entry != 0 && (snapshot[index] == 0 || getDepth(entry) > getDepth(snapshot[index])))
+			snapshot[index] = entry;
+	}
+}
+
+/**
+ * Stores every entry of `snapshot` into the transposition table of the calling thread, or the shared one if `SHARED_TT` is
+ * defined. The table must be allocated
+ */
+static void applyTTSnapshot(const TTSnapshot& snapshot)
+{
+	for (uint32 index = 0; index < snapshot.size(); index++)
+		if (snapshot[index] != 0)
+			storeTTEntry(index, snapshot[index]);
+}
+
+/**
+ * Writes the non-empty entries of `snapshot` to `path`, see `TTFileHeader`. Returns false if the file could not be written
+ */
+static bool writeTTSnapshot(const char* path, const TTSnapshot& snapshot)
+{
+	TTFileHeader header = {TT_FILE_MAGIC, TT_FILE_VERSION, NUM_CANONICAL_STATES, MIN_TOTAL, MAX_TOTAL, TOTAL_BITS, sizeof(uint16),
+		{0, 0}, 0, 0, 0};
+
+	// 
+	// Collect the runs of non-empty entries
+	// 
+
+	std::vector<uint8> runs;
+	for (uint32 index = 0; index < snapshot.size();)
+	{
+		if (snapshot[index] == 0)
+		{
+			index++;
+			continue;
+		}
+
+		uint32 first = index;
+		while (index < snapshot.size() && snapshot[index] != 0)
+			index++;
+
+		uint32 count = index - first;
+		size_t offset = runs.size();
+		runs.resize(offset + 2 * sizeof(uint32) + count * sizeof(uint16));
+		memcpy(&runs[offset], &first, sizeof(uint32));
+		memcpy(&runs[offset + sizeof(uint32)], &count, sizeof(uint32));
+		memcpy(&runs[offset + 2 * sizeof(uint32)], &snapshot[first], count * sizeof(uint16));
+
+		header.numRuns++;
+		header.numEntries += count;
+	}
+
+	header.checksum = hashFNV1a(hashFNV1a(FNV1A_OFFSET_BASIS, &header, sizeof(header)), runs.data(), runs.size());
+
+	FILE* out = fopen(path, "wb");
+	if (out == nullptr)
+		return false;
+
+	bool success = fwrite(&header, sizeof(header), 1, out) == 1
+		&& (runs.empty() || fwrite(runs.data(), 1, runs.size(), out) == runs.size());
+
+	return fclose(out) == 0 && success;
+}
+
+/**
+ * Reads a transposition table written by `writeTTSnapshot` from `path` into `snapshot`. Returns false if the file does not exist,
+ * does not match the current format or fails its checksum, in which case `snapshot` is left untouched
+ */
+static bool readTTSnapshot(const char* path, TTSnapshot& snapshot)
+{
+	FILE* in = fopen(path, "rb");
+	if (in == nullptr)
+		return false;
+
+	// 
+	// Validate the header before reading any run
+	// 
+
+	TTFileHeader header;
+	if (fread(&header, sizeof(header), 1, in) != 1 || header.magic != TT_FILE_MAGIC || header.version != TT_FILE_VERSION
+		|| header.totalBits != TOTAL_BITS || header.entryBytes != sizeof(uint16) || header.minTotal != MIN_TOTAL
+		|| header.maxTotal < MIN_TOTAL || header.maxTotal > MAX_TOTAL
+		|| header.numStates != getNumCanonicalStates(static_cast<Total>(header.maxTotal))
+		|| header.numRuns > header.numStates || header.numEntries > header.numStates)
+	{
+		fclose(in);
+		return false;
+	}
+
+	std::vector<uint8> runs(2 * sizeof(uint32) * static_cast<size_t>(header.numRuns)
+		+ sizeof(uint16) * static_cast<size_t>(header.numEntries));
+	char extra;
+	bool success = (runs.empty() || fread(runs.data(), 1, runs.size(), in) == runs.size()) && fread(&extra, 1, 1, in) == 0;
+	fclose(in);
+
+	if (!success)
+		return false;
+
+	uint64 checksum = header.checksum;
+	header.checksum = 0;
+	if (hashFNV1a(hashFNV1a(FNV1A_OFFSET_BASIS, &header, sizeof(header)), runs.data(), runs.size()) != checksum)
+		return false;
+
+	std::vector<uint16> entries(NUM_CANONICAL_STATES, 0);
+	size_t offset = 0;
+	for (uint32 run = 0; run < header.numRuns; run++)
+	{
+		if (offset + 2 * sizeof(uint32) > runs.size())
+			return false;
+
+		uint32 first;
+		uint32 count;
+		memcpy(&first, &runs[offset], sizeof(uint32));
+		memcpy(&count, &runs[offset + sizeof(uint32)], sizeof(uint32));
+		offset += 2 * sizeof(uint32);
+
+		if (first > header.numStates || count > header.numStates - first || offset + count * sizeof(uint16) > runs.size())
+			return false;
+
+		memcpy(&entries[first], &runs[offset], count * sizeof(uint16));
+		offset += count * sizeof(uint16);
+	}
+
+	snapshot.swap(entries);
+	return true;
+}
+
+/**
+ * Saves the transposition table of the calling thread, or the shared one if `SHARED_TT` is defined, to `path`. Returns false if
+ * the file could not be written
+ */
+static inline bool saveTranspositionTable(const char* path)
+{
+	TTSnapshot snapshot;
+	mergeTTSnapshot(snapshot);
+	return writeTTSnapshot(path, snapshot);
+}
+
+/**
+ * Loads a transposition table saved by `saveTranspositionTable` from `path` into the allocated table of the calling thread, or
+ * the shared one if `SHARED_TT` is defined. Returns false if the file is missing or invalid, in which case the table is left
+ * untouched
+ */
+static inline bool loadTranspositionTable(const char* path)
+{
+	TTSnapshot snapshot;
+	if (!readTTSnapshot(path, snapshot))
+		return false;
+
+	applyTTSnapshot(snapshot);
+	return true;
+}
@@ -8,4 +8,6 @@ typedef uint16_t	uint16;
 typedef uint64_t	uint64;
 
 typedef int8_t		int8;
-typedef int16_t		int16;
\ No newline at end of file
+typedef int16_t		int16;
+typedef int32_t		int32;
+typedef int64_t		int64;
\ No newline at end of file
@@ -0,0 +1,228 @@
+#pragma once
+
+#include "types.h"
+#include "rules.h"
+#include <ostream>
+#include <vector>
+
+/**
+ * The smallest total of a variant. It is reached by turning the dice to its highest face at a total of 1
+ */
+template<typename Rules>
+static inline constexpr int64 getVariantMinTotal() noexcept
+{
+	return 1 - static_cast<int64>(Rules::FACES);
+}
+
+/**
+ * The canonical index of the state with the given `total` whose dice shows `face`, in the same layout as `canonicalIndex`: dense in
+ * the order (total, face class). Like there, the active player does not matter
+ */
+template<typename Rules>
+static inline uint32 variantIndex(const int64& total, const uint8& face) noexcept
+{
+	return static_cast<uint32>(total - getVariantMinTotal<Rules>()) * RuleTablesOf<Rules>::VALUE.numClasses
+		+ RuleTablesOf<Rules>::VALUE.faceClasses[face];
+}
+
+/**
+ * The solved values of a variant for every total in {firstTotal, ..., lastTotal}. `values` is laid out like `variantIndex`,
+ * but starts at `firstTotal`, so a range starting at `getVariantMinTotal()` is the table of `solveVariant`
+ */
+typedef struct _VariantRange {
+	int64 firstTotal;
+	int64 lastTotal;
+	std::vector<int8> values;
+} VariantRange;
+
+/**
+ * Returns the value of the state with the given `total` whose dice shows `face` from `range`, which must cover the total
+ */
+template<typename Rules>
+static inline int8 getRangeValue(const VariantRange& range, const int64& total, const uint8& face) noexcept
+{
+	return range.values[static_cast<size_t>(total - range.firstTotal) * RuleTablesOf<Rules>::VALUE.numClasses
+		+ RuleTablesOf<Rules>::VALUE.faceClasses[face]];
+}
+
+/**
+ * Returns the value of a state with a total of zero or below, where the opponent just ended the game, from the point of view of
+ * the active player
+ */
+template<typename Rules>
+static inline constexpr int8 getVariantBaseValue(const int64& total) noexcept
+{
+	return static_cast<int8>(-Rules::getMoverOutcome(total));
+}
+
+/**
+ * Solves every state of a variant with a total in {firstTotal, ..., lastTotal} bottom-up into `values`, which is laid out like
+ * `variantIndex` but starts at `firstTotal`. This is the recurrence of every solver of the variants and of DiceFlip itself. A
+ * player whose dice shows a face without any legal move loses. One representative face per class is solved, the move tables are
+ * generated from the rules at compile time. Each total only depends on the `Rules::FACES` totals below it. Those below
+ * `firstTotal` and above zero are read from `below(total, face)`, totals of zero and below are base cases
+ */
+template<typename Rules, typename Below>
+static inline void solveVariantTotals(int8* values, const int64& firstTotal, const int64& lastTotal, const Below& below)
+{
+	const RuleTables<Rules>& tables = RuleTablesOf<Rules>::VALUE;
+
+	for (int64 total = firstTotal; total <= lastTotal; total++)
+	{
+		int8* totalValues = values + static_cast<size_t>(total - firstTotal) * tables.numClasses;
+
+		// 
+		// Classes are numbered in the order of their first face, which is the one solved
+		// 
+
+		uint8 nextClass = 0;
+		for (uint8 face = 1; face <= Rules::FACES; face++)
+		{
+			if (tables.faceClasses[face] != nextClass)
+				continue;
+			nextClass++;
+
+			// 
+			// Base case: the opponent moved the total to zero or below, from the point of view of the active player
+			// 
+
+			if (total <= 0)
+			{
+				totalValues[tables.faceClasses[face]] = getVariantBaseValue<Rules>(total);
+				continue;
+			}
+
+			int8 max = -1;
+			for (uint8 i = 0; i < tables.numMoves[face]; i++)
+			{
+				uint8 move = tables.moves[face][i];
+				int64 next = total - move;
+
+				int8 val;
+				if (next >= firstTotal)
+					val = -values[static_cast<size_t>(next - firstTotal) * tables.numClasses + tables.faceClasses[move]];
+				else if (next <= 0)
+					val = -getVariantBaseValue<Rules>(next);
+				else
+					val = -below(next, move);
+
+				if (val > max)
+					max = val;
+			}
+
+			totalValues[tables.faceClasses[face]] = max;
+		}
+	}
+}
+
+/**
+ * Solves every state of a variant with a total in {firstTotal, ..., lastTotal} by `solveVariantTotals`, just like `solveDP`
+ * does for DiceFlip, and writes the values to `range`. A range starting above a total of 1 needs the `Rules::FACES` totals below
+ * it from `boundary`, e.g. the end of the range below it, see `getRangeBoundary`. Totals of zero and below are base cases and
+ * never need a boundary. Returns false if `boundary` does not cover the totals needed or the range is empty
+ */
+template<typename Rules>
+static bool solveVariantRange(VariantRange& range, const VariantRange* boundary, const int64& firstTotal, const int64& lastTotal)
+{
+	if (firstTotal < getVariantMinTotal<Rules>() || lastTotal < firstTotal)
+		return false;
+
+	const int64 neededTotal = firstTotal - Rules::FACES > 1 ? firstTotal - Rules::FACES : 1;
+	if (firstTotal > 1 && (boundary == nullptr || boundary->firstTotal > neededTotal || boundary->lastTotal < firstTotal - 1))
+		return false;
+
+	range.firstTotal = firstTotal;
+	range.lastTotal = lastTotal;
+	range.values.assign(static_cast<size_t>(lastTotal - firstTotal + 1) * RuleTablesOf<Rules>::VALUE.numClasses, 0);
+
+	solveVariantTotals<Rules>(range.values.data(), firstTotal, lastTotal, [boundary](const int64& total, const uint8& face)
+	{
+		return getRangeValue<Rules>(*boundary, total, face);
+	});
+
+	return true;
+}
+
+/**
+ * Writes the last `Rules::FACES` totals above zero up to the end of `range` to `boundary`, all the range above it needs. A range
+ * shorter than that takes its older totals from `incoming`, the boundary it was solved with by `solveVariantRange`, so a
+ * boundary always covers every total the next range reads
+ */
+template<typename Rules>
+static void getRangeBoundary(VariantRange& boundary, const VariantRange& range, const VariantRange* incoming)
+{
+	const size_t numClasses = RuleTablesOf<Rules>::VALUE.numClasses;
+	const int64 lowestTotal = range.firstTotal < 1 ? range.firstTotal : 1;
+
+	boundary.lastTotal = range.lastTotal;
+	boundary.firstTotal = range.lastTotal - Rules::FACES + 1 > lowestTotal ? range.lastTotal - Rules::FACES + 1 : lowestTotal;
+	boundary.values.clear();
+
+	for (int64 total = boundary.firstTotal; total <= boundary.lastTotal; total++)
+	{
+		const VariantRange& source = total >= range.firstTotal ? range : *incoming;
+		std::vector<int8>::const_iterator values = source.values.begin() + static_cast<size_t>(total - source.firstTotal) * numClasses;
+		boundary.values.insert(boundary.values.end(), values, values + numClasses);
+	}
+}
+
+/**
+ * Solves every state of a variant with a total in {getVariantMinTotal(), ..., maxTotal} and writes the values to `values`,
+ * indexed by `variantIndex`, see `solveVariantRange`
+ */
+template<typename Rules>
+static void solveVariant(std::vector<int8>& values, const int64& maxTotal)
+{
+	VariantRange range;
+	solveVariantRange<Rules>(range, nullptr, getVariantMinTotal<Rules>(), maxTotal);
+	values.swap(range.values);
+}
+
+/**
+ * Returns the value of the state with the given `total` whose dice shows `face` from a table filled by `solveVariant`, from the
+ * point of view of the active player
+ */
+template<typename Rules>
+static inline int8 getVariantValue(const std::vector<int8>& values, const int64& total, const uint8& face) noexcept
+{
+	return values[variantIndex<Rules>(total, face)];
+}
+
+/**
+ * Solves a variant up to `maxStartTotal` and writes how many of the starting positions with totals in
+ * {minStartTotal, ..., maxStartTotal} and any face are won by the starting player to `out`
+ */
+template<typename Rules>
+static void reportVariant(std::ostream& out, const int64& minStartTotal, const int64& maxStartTotal)
+{
+	std::vector<int8> values;
+	solveVariant<Rules>(values, maxStartTotal);
+
+	uint64 starts = 0;
+	uint64 starterWins = 0;
+	for (int64 total = minStartTotal; total <= maxStartTotal; total++)
+	{
+		for (uint8 face = 1; face <= Rules::FACES; face++)
+		{
+			starts++;
+			starterWins += getVariantValue<Rules>(values, total, face) == 1;
+		}
+	}
+
+	out << Rules::getName() << ": the starting player wins " << starterWins << " of " << starts << " starting positions ("
+		<< static_cast<int>(RuleTablesOf<Rules>::VALUE.numClasses) << " face classes)\n";
+}
+
+/**
+ * Reports every combination of the options of `DiceRules` for a dice with `Faces` faces, see `reportVariant`
+ */
+template<uint8 Faces>
+static void reportDiceVariants(std::ostream& out, const int64& minStartTotal, const int64& maxStartTotal)
+{
+	reportVariant<DiceRules<Faces, true, false, false>>(out, minStartTotal, maxStartTotal);
+	reportVariant<DiceRules<Faces, true, true, false>>(out, minStartTotal, maxStartTotal);
+	reportVariant<DiceRules<Faces, true, true, true>>(out, minStartTotal, maxStartTotal);
+	reportVariant<DiceRules<Faces, false, false, false>>(out, minStartTotal, maxStartTotal);
+	reportVariant<DiceRules<Faces, false, true, false>>(out, minStartTotal, maxStartTotal);
+	reportVariant<DiceRules<Faces, false, true, true>>(out, minStartTotal, maxStartTotal);
+}
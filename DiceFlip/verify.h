@@ -0,0 +1,258 @@
+#pragma once
+
+#include "game.h"
+#include "transposition.h"
+#include "minimax.h"
+#include "batch.h"
+#include "dpsolver.h"
+#include "batchquery.h"
+#include "variantsolver.h"
+#include "packedsolution.h"
+#include "random.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Checks whether the transposition table `entry` of the given `GameState` agrees with its exact evaluation `value`. Entries whose
+ * search may have stopped at the maximum depth cannot be checked and are accepted. A game starting at `total` ends after at most
+ * `total` moves, so that only applies to entries with a smaller depth. Best moves must reach the stored evaluation
+ */
+static bool isTTEntryConsistent(const uint16& entry, const GameState& state, const int8& value, const int8* values)
+{
+	uint8 depth = getDepth(entry);
+	if (depth != PROVEN_DEPTH && depth < state.total)
+		return true;
+
+	int8 rating = getRating(entry);
+	NodeType type = getNodeType(entry);
+
+	if ((type == NODE_TYPE_EXACT && value != rating)
+		|| (type == NODE_TYPE_LOWER && value < rating)
+		|| (type == NODE_TYPE_UPPER && value > rating))
+		return false;
+
+	Move bestMove = getBestMove(entry);
+	if (bestMove == 0 || type == NODE_TYPE_UPPER)
+		return true;
+
+	return isLegalMove(state.lastMove, bestMove) && -getDPValue(values, performMove(state, bestMove)) >= rating;
+}
+
+/**
+ * Verifies the transposition table backed search against the plain minimax values of `solveDP`. Every state of `states` is
+ * searched by `searchState` with the transposition table of the calling thread, just as in the sweep. Afterwards every entry the
+ * searches left in the table is checked by `isTTEntryConsistent`. Mismatches and a summary are written to `out`. Returns true if
+ * neither the searches nor the entries disagree with `solveDP`
+ */
+static inline bool verifySearch(const std::vector<GameState>& states, std::ostream& out)
+{
+	static int8 values[NUM_CANONICAL_STATES];
+
+	Total maxTotal = 0;
+	for (const GameState& state : states)
+		if (state.total > maxTotal)
+			maxTotal = state.total;
+
+	solveDP(values, maxTotal);
+
+	// 
+	// Search every state
+	// 
+
+	uint64 searchMismatches = 0;
+	for (const GameState& state : states)
+	{
+		int8 searched = searchState(state, 100, -128, 127);
+		int8 expected = getDPValue(values, state);
+		if (searched != expected)
+		{
+			searchMismatches++;
+			out << "[verify] Searched " << std::to_string(searched) << " instead of " << std::to_string(expected) << " for dice "
+				<< std::to_string(state.lastMove) << ", player " << std::to_string(state.activePlayer) << ", total "
+				<< std::to_string(state.total) << "\n";
+		}
+	}
+
+	// 
+	// Check every entry of the transposition table
+	// 
+
+	uint64 entriesChecked = 0;
+	uint64 entryMismatches = 0;
+	for (int64 total = 1; total <= maxTotal; total++)
+	{
+		for (Move lastMove = 1; lastMove <= 3; lastMove++)
+		{
+			GameState state = createGameState(lastMove, 1, static_cast<Total>(total));
+			uint16 entry = loadTTEntry(canonicalIndex(state));
+			if (entry == 0)
+				continue;
+
+			entriesChecked++;
+			if (!isTTEntryConsistent(entry, state, getDPValue(values, state), values))
+			{
+				entryMismatches++;
+				out << "[verify] Inconsistent entry 0x" << std::hex << entry << std::dec << " for dice " << std::to_string(lastMove)
+					<< ", total " << std::to_string(total) << "\n";
+			}
+		}
+	}
+
+	out << "[verify] " << states.size() << " searches (" << searchMismatches << " mismatches), " << entriesChecked
+		<< " transposition table entries (" << entryMismatches << " mismatches)\n";
+
+	return searchMismatches == 0 && entryMismatches == 0;
+}
+
+/**
+ * Checks whether two GameStates are equal in every member
+ */
+static inline bool isSameGameState(const GameState& a, const GameState& b) noexcept
+{
+	return a.total == b.total && a.lastMove == b.lastMove && a.activePlayer == b.activePlayer && a.winner == b.winner;
+}
+
+/**
+ * Verifies `performMoveBatch`, `evalBatch`, `getPossibleStatesBatch` and `getSuccessorIndicesBatch` against `performMove`, `eval`,
+ * `getPossibleStates` and `canonicalIndex` on `count` random states with random legal moves. Half of the states have a total of at most 6, so many of their successors end
+ * the game. `count` should not be a multiple of 4, so the scalar tails are checked as well. A summary is written to `out`.
+ * Returns true if every result matches
+ */
+static inline bool verifyBatchOperations(const size_t& count, std::ostream& out)
+{
+	Random random;
+	seedRandom(random, 8);
+
+	std::vector<GameState> states(count);
+	std::vector<Move> moves(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		Total total = static_cast<Total>(1 + nextRandom(random) % ((i & 1) != 0 ? 6 : MAX_TOTAL));
+		states[i] = createGameState(rollDice(random), (nextRandom(random) & 1) != 0 ? 1 : -1, total);
+
+		do
+		{
+			moves[i] = rollDice(random);
+		} while (!isLegalMove(states[i].lastMove, moves[i]));
+	}
+
+	std::vector<GameState> moved(count);
+	std::vector<int8> evals(count);
+	std::vector<GameState> successors(4 * count);
+	std::vector<uint32> indices(4 * count);
+	performMoveBatch(moved.data(), states.data(), moves.data(), count);
+	evalBatch(evals.data(), moved.data(), count);
+	getPossibleStatesBatch(successors.data(), states.data(), count);
+	getSuccessorIndicesBatch(indices.data(), states.data(), count);
+
+	uint64 mismatches = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		GameState expected[4];
+		getPossibleStates(expected, states[i]);
+
+		bool matches = isSameGameState(moved[i], performMove(states[i], moves[i])) && evals[i] == eval(moved[i]);
+		for (uint8 j = 0; j < 4; j++)
+			matches = matches && isSameGameState(successors[4 * i + j], expected[j]) && indices[4 * i + j] == canonicalIndex(expected[j]);
+
+		if (!matches)
+		{
+			mismatches++;
+			out << "[verify] Batch operations disagree for dice " << std::to_string(states[i].lastMove) << ", total "
+				<< std::to_string(states[i].total) << " and move " << std::to_string(moves[i]) << "\n";
+		}
+	}
+
+	out << "[verify] " << count << " batch operations (" << mismatches << " mismatches)\n";
+	return mismatches == 0;
+}
+
+/**
+ * Verifies that `solveDP`, `extendDP` extending a table solved up to half of `maxTotal`, `solveVariant` of `StandardRules` and
+ * `solvePacked` produce the same value for every state up to `maxTotal`. The first two expand layers of GameStates with the
+ * operations of `batch.h`, the others run `solveVariantTotals`. A summary is written to `out`. Returns true if they all agree
+ */
+static inline bool verifyDPSolvers(const Total& maxTotal, std::ostream& out)
+{
+	static int8 values[NUM_CANONICAL_STATES];
+	static int8 extended[NUM_CANONICAL_STATES];
+	solveDP(values, maxTotal);
+	solveDP(extended, maxTotal / 2);
+	extendDP(extended, maxTotal / 2, maxTotal);
+
+	std::vector<int8> variantValues;
+	solveVariant<StandardRules>(variantValues, maxTotal);
+
+	PackedSolution packed;
+	solvePacked(packed, maxTotal);
+
+	uint64 mismatches = 0;
+	for (int64 total = MIN_TOTAL; total <= maxTotal; total++)
+	{
+		for (Move lastMove = 1; lastMove <= 6; lastMove++)
+		{
+			uint32 index = canonicalIndex(createGameState(lastMove, 1, static_cast<Total>(total)));
+			mismatches += extended[index] != values[index] || getVariantValue<StandardRules>(variantValues, total, lastMove) != values[index]
+				|| getPackedRating(packed, index) != values[index];
+		}
+	}
+
+	out << "[verify] " << getNumCanonicalStates(maxTotal) << " solved states (" << mismatches << " mismatches)\n";
+	return mismatches == 0;
+}
+
+/**
+ * Verifies `searchBatch` against the plain minimax values of `solveDP` for every state up to `maxTotal`. A single query of
+ * `maxTotal` is searched first, while the transposition table of the calling thread holds none of the totals below, then the
+ * states of every total in descending order, and then enough copies of them to be split over four threads, which start with
+ * empty tables. Every evaluation must match and every best move must reach it. The solution database must not be open, otherwise
+ * the queries would be looked up instead of searched. Mismatches and a summary are written to `out`. Returns true if no answer
+ * disagrees with `solveDP`
+ */
+static inline bool verifyBatchSearch(const Total& maxTotal, std::ostream& out)
+{
+	static int8 values[NUM_CANONICAL_STATES];
+	solveDP(values, maxTotal);
+
+	std::vector<GameState> sparse(1, createGameState(1, 1, maxTotal));
+	std::vector<GameState> states;
+	for (int64 total = maxTotal; total >= 1; total--)
+		for (Move lastMove = 1; lastMove <= 6; lastMove++)
+			for (Player player = -1; player <= 1; player += 2)
+				states.push_back(createGameState(lastMove, player, static_cast<Total>(total)));
+
+	std::vector<GameState> split;
+	while (split.size() < 4 * MIN_QUERIES_PER_THREAD)
+		split.insert(split.end(), states.begin(), states.end());
+
+	std::vector<QueryResult> sparseResults(sparse.size());
+	std::vector<QueryResult> results(states.size());
+	std::vector<QueryResult> splitResults(split.size());
+	searchBatch(sparse.data(), sparse.size(), sparseResults.data());
+	searchBatch(states.data(), states.size(), results.data());
+	searchBatch(split.data(), split.size(), splitResults.data(), 4);
+
+	states.insert(states.begin(), sparse.begin(), sparse.end());
+	results.insert(results.begin(), sparseResults.begin(), sparseResults.end());
+	states.insert(states.end(), split.begin(), split.end());
+	results.insert(results.end(), splitResults.begin(), splitResults.end());
+
+	uint64 mismatches = 0;
+	for (size_t i = 0; i < states.size(); i++)
+	{
+		const GameState& state = states[i];
+		int8 expected = getDPValue(values, state);
+		if (results[i].eval != expected || !isLegalMove(state.lastMove, results[i].bestMove)
+			|| -getDPValue(values, performMove(state, results[i].bestMove)) != expected)
+		{
+			mismatches++;
+			out << "[verify] Batch answered " << std::to_string(results[i].eval) << " and move " << std::to_string(results[i].bestMove)
+				<< " instead of " << std::to_string(expected) << " for dice " << std::to_string(state.lastMove) << ", total "
+				<< std::to_string(state.total) << "\n";
+		}
+	}
+
+	out << "[verify] " << states.size() << " batch queries (" << mismatches << " mismatches)\n";
+	return mismatches == 0;
+}
@@ -0,0 +1,668 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include "types.h"
+#include "game.h"
+#include "transposition.h"
+#include "minimax.h"
+#include "dpsolver.h"
+#include "solutiondb.h"
+#include "iterativesearch.h"
+#include "pvsearch.h"
+#include "solver.h"
+#include "packedsolution.h"
+#include "anytime.h"
+#include "batchquery.h"
+#include "variantsolver.h"
+#include "periodic.h"
+#include "ttpersist.h"
+#include "server.h"
+
+/**
+ * Path of the solution database written by the benchmarks. It is separate from the one of DiceFlip so both can run side by side
+ */
+static constexpr const char* BENCH_DB_PATH = "./bench_solutions.db";
+
+/**
+ * Path of the transposition table saved by the benchmarks
+ */
+static constexpr const char* BENCH_TT_PATH = "./bench_transposition.tt";
+
+/**
+ * Keeps the compiler from optimizing away the benchmarked work
+ */
+static volatile uint64 sink = 0;
+
+typedef std::chrono::steady_clock Clock;
+
+/**
+ * Returns the nanoseconds passed since `start`
+ */
+static inline double nanosecondsSince(const Clock::time_point& start)
+{
+	return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+}
+
+/**
+ * Writes a benchmark result as a single JSON line to stdout
+ */
+static void report(const char* name, const uint64& iterations, const double& totalNanoseconds)
+{
+	printf("{\"benchmark\":\"%s\",\"iterations\":%llu,\"total_ns\":%.0f,\"ns_per_op\":%.3f}\n",
+		name, static_cast<unsigned long long>(iterations), totalNanoseconds, totalNanoseconds / iterations);
+}
+
+/**
+ * Writes the percentiles of the given latencies as a single JSON line to stdout
+ */
+static void reportLatencies(const char* name, std::vector<double>& latencies)
+{
+	std::sort(latencies.begin(), latencies.end());
+
+	double sum = 0;
+	for (double latency : latencies)
+		sum += latency;
+
+	size_t n = latencies.size();
+	printf("{\"benchmark\":\"%s\",\"iterations\":%llu,\"mean_ns\":%.1f,\"p50_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f,\"max_ns\":%.1f}\n",
+		name, static_cast<unsigned long long>(n), sum / n, latencies[n / 2], latencies[n * 9 / 10], latencies[n * 99 / 100], latencies[n - 1]);
+}
+
+/**
+ * Returns every starting position of the sweep in `main`, in the same order
+ */
+static std::vector<GameState> getSweepStates()
+{
+	std::vector<GameState> states;
+	for (Total startTotal = 66; startTotal >= 11; startTotal--)
+		for (Move startMove = 1; startMove <= 6; startMove++)
+			states.push_back(createGameState(startMove, -1, startTotal));
+	return states;
+}
+
+/**
+ * Times `hash` and `canonicalIndex` over every state up to a total of 66
+ */
+static void benchmarkHash()
+{
+	std::vector<GameState> states;
+	for (Total total = MIN_TOTAL; total <= 66; total++)
+		for (Move lastMove = 1; lastMove <= 6; lastMove++)
+			for (Player player = -1; player <= 1; player += 2)
+				states.push_back(performMove(createGameState(lastMove, player, static_cast<Total>(total + lastMove)), lastMove));
+
+	const uint64 rounds = 20000;
+	uint64 acc = 0;
+
+	Clock::time_point start = Clock::now();
+	for (uint64 r = 0; r < rounds; r++)
+		for (const GameState& state : states)
+			acc += hash(state);
+	double ns = nanosecondsSince(start);
+
+	report("hash", rounds * states.size(), ns);
+
+	start = Clock::now();
+	for (uint64 r = 0; r < rounds; r++)
+		for (const GameState& state : states)
+			acc += canonicalIndex(state);
+	ns = nanosecondsSince(start);
+
+	sink += acc;
+	report("canonicalIndex", rounds * states.size(), ns);
+}
+
+/**
+ * Times `getPossibleStates` over every non-terminal state up to a total of 66
+ */
+static void benchmarkGetPossibleStates()
+{
+	std::vector<GameState> states;
+	for (Total total = 1; total <= 66; total++)
+		for (Move lastMove = 1; lastMove <= 6; lastMove++)
+			states.push_back(createGameState(lastMove, 1, total));
+
+	const uint64 rounds = 20000;
+	uint64 acc = 0;
+
+	Clock::time_point start = Clock::now();
+	for (uint64 r = 0; r < rounds; r++)
+	{
+		for (const GameState& state : states)
+		{
+			GameState out[4];
+			getPossibleStates(out, state);
+			acc += out[0].total + out[1].total + out[2].total + out[3].total;
+		}
+	}
+	double ns = nanosecondsSince(start);
+
+	sink += acc;
+	report("getPossibleStates", rounds * states.size(), ns);
+}
+
+/**
+ * The signature shared by `miniMax` and `miniMaxIterative`
+ */
+typedef int8 (*SearchFunction)(const GameState&, const uint8&, int8, int8);
+
+/**
+ * Adapts `miniMaxIterative` to `SearchFunction`
+ */
+static int8 searchIterative(const GameState& curState, const uint8& depth, int8 alpha, int8 beta)
+{
+	return miniMaxIterative(curState, depth, alpha, beta);
+}
+
+/**
+ * Adapts `miniMaxPVS` to `SearchFunction`
+ */
+static int8 searchPVS(const GameState& curState, const uint8& depth, int8 alpha, int8 beta)
+{
+	return miniMaxPVS(curState, depth, alpha, beta);
+}
+
+/**
+ * Times `search` at depth 100 from the given starting total with an empty (cold) and with an already filled (warm) transposition
+ * table
+ */
+static void benchmarkSearch(const char* name, SearchFunction search, const Total& startTotal)
+{
+	const uint64 rounds = 200;
+	double coldNs = 0;
+	double warmNs = 0;
+	uint64 acc = 0;
+
+	for (uint64 r = 0; r < rounds; r++)
+	{
+		allocateTranspositionTable();
+
+		for (Move startMove = 1; startMove <= 6; startMove++)
+		{
+			GameState state = createGameState(startMove, -1, startTotal);
+
+			Clock::time_point start = Clock::now();
+			acc += search(state, 100, -128, 127);
+			coldNs += nanosecondsSince(start);
+
+			start = Clock::now();
+			acc += search(state, 100, -128, 127);
+			warmNs += nanosecondsSince(start);
+		}
+
+		freeTranspositionTable();
+	}
+
+	sink += acc;
+
+	std::string fullName = std::string(name) + "_cold_total" + std::to_string(startTotal);
+	report(fullName.c_str(), rounds * 6, coldNs);
+	fullName = std::string(name) + "_warm_total" + std::to_string(startTotal);
+	report(fullName.c_str(), rounds * 6, warmNs);
+}
+
+/**
+ * Times the evaluation of the full 66..11 sweep, once with `miniMax` sharing one transposition table like `main` does and
+ * once with `solveDP`
+ */
+static void benchmarkSweep()
+{
+	std::vector<GameState> states = getSweepStates();
+	const uint64 rounds = 20;
+	uint64 acc = 0;
+
+	Clock::time_point start = Clock::now();
+	for (uint64 r = 0; r < rounds; r++)
+	{
+		allocateTranspositionTable();
+		for (const GameState& state : states)
+			acc += miniMax(state, 100, -128, 127);
+		freeTranspositionTable();
+	}
+	report("sweep_miniMax", rounds, nanosecondsSince(start));
+
+	static int8 values[NUM_CANONICAL_STATES];
+	const uint64 dpRounds = 2000;
+
+	start = Clock::now();
+	for (uint64 r = 0; r < dpRounds; r++)
+	{
+		solveDP(values, 66);
+		for (const GameState& state : states)
+			acc += getDPValue(values, state);
+	}
+	report("sweep_solveDP", dpRounds, nanosecondsSince(start));
+
+	sink += acc;
+}
+
+/**
+ * Times searching every total up to `MAX_TOTAL` in ascending order into a freshly allocated transposition table, which touches
+ * every page of it for the first time. Compare builds with and without `SEGMENTED_TT` and `HUGE_PAGE_TT` to see the cost of the
+ * page faults
+ */
+static void benchmarkFreshTable()
+{
+	const uint64 rounds = MAX_TOTAL > 1000 ? 1 : 200;
+	uint64 acc = 0;
+
+	Clock::time_point start = Clock::now();
+	for (uint64 r = 0; r < rounds; r++)
+	{
+		allocateTranspositionTable();
+		for (int64 total = 1; total <= MAX_TOTAL; total++)
+			for (Move lastMove = 1; lastMove <= 3; lastMove++)
+				acc += searchState(createGameState(lastMove, 1, static_cast<Total>(total)), 100, -128, 127);
+		freeTranspositionTable();
+	}
+	report("tt_fresh_search_all_totals", rounds * 3 * MAX_TOTAL, nanosecondsSince(start));
+
+	sink += acc;
+}
+
+/**
+ * Times saving a transposition table filled by searching every total up to `MAX_TOTAL`, loading it into a fresh table and
+ * searching the same totals again from the loaded table
+ */
+static void benchmarkWarmStart()
+{
+	uint64 acc = 0;
+
+	allocateTranspositionTable();
+	for (int64 total = 1; total <= MAX_TOTAL; total++)
+		for (Move lastMove = 1; lastMove <= 3; lastMove++)
+			acc += searchState(createGameState(lastMove, 1, static_cast<Total>(total)), 100, -128, 127);
+
+	Clock::time_point start = Clock::now();
+	bool saved = saveTranspositionTable(BENCH_TT_PATH);
+	report("tt_save", 1, nanosecondsSince(start));
+	freeTranspositionTable();
+
+	allocateTranspositionTable();
+	start = Clock::now();
+	bool loaded = saved && loadTranspositionTable(BENCH_TT_PATH);
+	report("tt_load", 1, nanosecondsSince(start));
+
+	if (loaded)
+	{
+		start = Clock::now();
+		for (int64 total = 1; total <= MAX_TOTAL; total++)
+			for (Move lastMove = 1; lastMove <= 3; lastMove++)
+				acc += searchState(createGameState(lastMove, 1, static_cast<Total>(total)), 100, -128, 127);
+		report("tt_warm_search_all_totals", 3 * MAX_TOTAL, nanosecondsSince(start));
+	}
+	freeTranspositionTable();
+
+	remove(BENCH_TT_PATH);
+	sink += acc;
+}
+
+/**
+ * Measures the latency of single `makeBestMove` calls from every state of the sweep, searched by `miniMax` and looked up from the
+ * solution database
+ */
+static void benchmarkMakeBestMove()
+{
+	std::vector<GameState> states = getSweepStates();
+	std::vector<double> latencies;
+	const uint64 rounds = 20;
+	uint64 acc = 0;
+
+	allocateTranspositionTable();
+
+	for (uint64 r = 0; r < rounds; r++)
+	{
+		for (const GameState& state : states)
+		{
+			Clock::time_point start = Clock::now();
+			acc += makeBestMove(state).lastMove;
+			latencies.push_back(nanosecondsSince(start));
+		}
+	}
+	reportLatencies("makeBestMove_miniMax", latencies);
+
+	if (loadOrCreateSolutionDB(solutionDB, BENCH_DB_PATH, MAX_TOTAL))
+	{
+		latencies.clear();
+		for (uint64 r = 0; r < rounds * 100; r++)
+		{
+			for (const GameState& state : states)
+			{
+				Clock::time_point start = Clock::now();
+				acc += makeBestMove(state).lastMove;
+				latencies.push_back(nanosecondsSince(start));
+			}
+		}
+		reportLatencies("makeBestMove_solutionDB", latencies);
+
+		closeSolutionDB(solutionDB);
+		remove(BENCH_DB_PATH);
+	}
+
+	freeTranspositionTable();
+	sink += acc;
+}
+
+/**
+ * Times solving and extending the upper half of a `Solver`, then measures the throughput of `Solver::makeBestMove` queried by 1,
+ * 2, 4 and 8 threads at once from the states of the sweep
+ */
+static void benchmarkSolver()
+{
+	Clock::time_point start = Clock::now();
+	Solver solver;
+	solver.solve(MAX_TOTAL);
+	report("solver_solve", 1, nanosecondsSince(start));
+
+	Solver extended;
+	extended.solve(MAX_TOTAL / 2);
+	start = Clock::now();
+	extended.extend(MAX_TOTAL);
+	report("solver_extend_half", 1, nanosecondsSince(start));
+
+	std::vector<GameState> states = getSweepStates();
+	const uint64 rounds = 2000;
+
+	for (unsigned numThreads = 1; numThreads <= 8; numThreads *= 2)
+	{
+		std::vector<std::thread> threads;
+		std::vector<uint64> accs(numThreads);
+
+		start = Clock::now();
+		for (unsigned t = 0; t < numThreads; t++)
+		{
+			threads.emplace_back([&solver, &states, &accs, rounds, t]()
+			{
+				uint64 acc = 0;
+				for (uint64 r = 0; r < rounds; r++)
+					for (const GameState& state : states)
+						acc += solver.makeBestMove(state).lastMove;
+				accs[t] = acc;
+			});
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		double ns = nanosecondsSince(start);
+		for (uint64 acc : accs)
+			sink += acc;
+
+		std::string name = "solver_makeBestMove_threads" + std::to_string(numThreads);
+		report(name.c_str(), rounds * states.size() * numThreads, ns);
+	}
+}
+
+/**
+ * Times solving every total up to `MAX_TOTAL` into a packed solution and into the byte per state table of `solveDP`, and random
+ * lookups of evaluations from both. Once the byte table outgrows the caches, the four times smaller packed one is faster
+ */
+static void benchmarkPackedSolution()
+{
+	Clock::time_point start = Clock::now();
+	PackedSolution solution;
+	solvePacked(solution, MAX_TOTAL);
+	report("packed_solve", 1, nanosecondsSince(start));
+
+	start = Clock::now();
+	std::vector<int8> values(NUM_CANONICAL_STATES);
+	solveDP(values.data(), MAX_TOTAL);
+	report("packed_solveDP", 1, nanosecondsSince(start));
+
+	Random random;
+	seedRandom(random, 42);
+	std::vector<uint32> indices(1 << 20);
+	for (uint32& index : indices)
+		index = static_cast<uint32>(nextRandom(random) % NUM_CANONICAL_STATES);
+
+	uint64 acc = 0;
+
+	start = Clock::now();
+	for (uint32 index : indices)
+		acc += getPackedRating(solution, index);
+	report("packed_lookup", indices.size(), nanosecondsSince(start));
+
+	start = Clock::now();
+	for (uint32 index : indices)
+		acc += values[index];
+	report("packed_lookup_solveDP", indices.size(), nanosecondsSince(start));
+
+	sink += acc;
+}
+
+/**
+ * Times solving every total up to `MAX_TOTAL` with `solveVariant` of `StandardRules` against `solveDP`, which runs the same
+ * recurrence on the table of DiceFlip with the batched layers of `batch.h`, and with the solver of a variant without the opposite
+ * face rule, which has twice the face classes
+ */
+static void benchmarkVariantSolver()
+{
+	Clock::time_point start = Clock::now();
+	std::vector<int8> values(NUM_CANONICAL_STATES);
+	solveDP(values.data(), MAX_TOTAL);
+	report("variant_solveDP", 1, nanosecondsSince(start));
+
+	std::vector<int8> variantValues;
+
+	start = Clock::now();
+	solveVariant<StandardRules>(variantValues, MAX_TOTAL);
+	report("variant_solve_standard", 1, nanosecondsSince(start));
+	sink += variantValues[variantValues.size() - 1];
+
+	start = Clock::now();
+	solveVariant<DiceRules<6, false, false, false>>(variantValues, MAX_TOTAL);
+	report("variant_solve_d6_opposite_allowed", 1, nanosecondsSince(start));
+	sink += variantValues[variantValues.size() - 1] + values[values.size() - 1];
+}
+
+/**
+ * Times detecting the period of DiceFlip and O(1) lookups of random totals up to 2^60 from it, which no table could hold
+ */
+static void benchmarkPeriodic()
+{
+	Clock::time_point start = Clock::now();
+	PeriodicSolution solution;
+	detectPeriod(solution, 1000);
+	report("periodic_detect", 1, nanosecondsSince(start));
+
+	Random random;
+	seedRandom(random, 42);
+	std::vector<int64> totals(1 << 20);
+	for (int64& total : totals)
+		total = static_cast<int64>(nextRandom(random) >> 4);
+
+	uint64 acc = 0;
+
+	start = Clock::now();
+	for (int64 total : totals)
+		acc += getPeriodicValue(solution, total, static_cast<uint8>(total % 6 + 1));
+	report("periodic_lookup", totals.size(), nanosecondsSince(start));
+
+	sink += acc;
+}
+
+/**
+ * Times answering a pipelined buffer of random move requests of the move server, without any socket
+ */
+static void benchmarkServerRequests()
+{
+	Solver solver;
+	solver.solve(MAX_TOTAL);
+	PeriodicSolution periodic;
+	detectPeriod(periodic, 1000);
+
+	Random random;
+	seedRandom(random, 42);
+	const size_t numRequests = 1 << 16;
+	std::string requests;
+	for (size_t i = 0; i < numRequests; i++)
+	{
+		uint64 roll = nextRandom(random);
+		requests += (roll & 1) != 0 ? "move " : "eval ";
+		requests += std::to_string((roll >> 8) % (2 * static_cast<uint64>(MAX_TOTAL)) + 1);
+		requests += " ";
+		requests += std::to_string((roll >> 4) % 6 + 1);
+		requests += "\n";
+	}
+
+	ServerConnection connection = {INVALID_SERVER_SOCKET, {}, {}, false};
+	connection.output.reserve(numRequests * 8);
+
+	Clock::time_point start = Clock::now();
+	handleRequests(solver, periodic, connection, requests.data(), requests.size());
+	report("server_requests", numRequests, nanosecondsSince(start));
+
+	sink += connection.output.size();
+}
+
+/**
+ * Times rolling dice with `rand() % 6`, the generator of the calling thread and `fillRolls`
+ */
+static void benchmarkRollDice()
+{
+	const uint64 rolls = 1 << 22;
+	uint64 acc = 0;
+
+	Clock::time_point start = Clock::now();
+	for (uint64 i = 0; i < rolls; i++)
+		acc += (rand() % 6) + 1;
+	report("rollDice_rand", rolls, nanosecondsSince(start));
+
+	start = Clock::now();
+	for (uint64 i = 0; i < rolls; i++)
+		acc += rollDice();
+	report("rollDice_xoshiro", rolls, nanosecondsSince(start));
+
+	std::vector<uint8> buffer(rolls);
+	start = Clock::now();
+	fillRolls(threadRandom(), buffer.data(), buffer.size());
+	report("fillRolls", rolls, nanosecondsSince(start));
+
+	for (uint8 roll : buffer)
+		acc += roll;
+	sink += acc;
+}
+
+/**
+ * Measures the latency percentiles of `searchBestMove` from every state up to `MAX_TOTAL` with budgets of 5 and 50 microseconds,
+ * starting with an empty transposition table each
+ */
+static void benchmarkAnytime()
+{
+	const long budgets[2] = {5, 50};
+	uint64 acc = 0;
+
+	for (long budgetMicroseconds : budgets)
+	{
+		SearchBudget budget = {std::chrono::microseconds(budgetMicroseconds), 0};
+		std::vector<double> latencies;
+
+		allocateTranspositionTable();
+		for (int64 total = MAX_TOTAL; total >= 1; total--)
+		{
+			for (Move lastMove = 1; lastMove <= 6; lastMove++)
+			{
+				GameState state = createGameState(lastMove, 1, static_cast<Total>(total));
+				Clock::time_point start = Clock::now();
+				acc += searchBestMove(state, budget).bestMove;
+				latencies.push_back(nanosecondsSince(start));
+			}
+		}
+		freeTranspositionTable();
+
+		std::string name = "anytime_budget" + std::to_string(budgetMicroseconds) + "us";
+		reportLatencies(name.c_str(), latencies);
+	}
+
+	sink += acc;
+}
+
+/**
+ * Times answering a batch of random states up to `MAX_TOTAL` with `Solver::queryBatch` and with `searchBatch` on an empty
+ * transposition table, on one thread and on every core, each compared to answering the states one by one
+ */
+static void benchmarkBatch()
+{
+	Random random;
+	seedRandom(random, 7);
+
+	std::vector<GameState> states(1 << 16);
+	for (GameState& state : states)
+	{
+		Total total = static_cast<Total>(1 + nextRandom(random) % MAX_TOTAL);
+		state = createGameState(rollDice(random), (nextRandom(random) & 1) ? 1 : -1, total);
+	}
+
+	std::vector<QueryResult> results(states.size());
+	uint64 acc = 0;
+
+	Solver solver;
+	solver.solve(MAX_TOTAL);
+
+	Clock::time_point start = Clock::now();
+	for (const GameState& state : states)
+		acc += solver.evaluate(state) + solver.bestMove(state);
+	report("batch_solver_single", states.size(), nanosecondsSince(start));
+
+	start = Clock::now();
+	solver.queryBatch(states.data(), states.size(), results.data());
+	report("batch_solver_queryBatch", states.size(), nanosecondsSince(start));
+
+	allocateTranspositionTable();
+	start = Clock::now();
+	for (const GameState& state : states)
+		acc += searchQuery(state).bestMove;
+	report("batch_search_single", states.size(), nanosecondsSince(start));
+	freeTranspositionTable();
+
+	allocateTranspositionTable();
+	start = Clock::now();
+	searchBatch(states.data(), states.size(), results.data());
+	report("batch_search_searchBatch", states.size(), nanosecondsSince(start));
+	freeTranspositionTable();
+
+	unsigned numThreads = std::thread::hardware_concurrency();
+	allocateTranspositionTable();
+	start = Clock::now();
+	searchBatch(states.data(), states.size(), results.data(), numThreads > 0 ? numThreads : 1);
+	report("batch_search_searchBatch_threads", states.size(), nanosecondsSince(start));
+	freeTranspositionTable();
+
+	for (const QueryResult& result : results)
+		acc += result.bestMove;
+	sink += acc;
+}
+
+/**
+ * Runs every benchmark. The results are written to stdout as JSON lines, so they can be collected and compared across versions
+ */
+int main()
+{
+	benchmarkHash();
+	benchmarkGetPossibleStates();
+	benchmarkRollDice();
+	benchmarkSearch("miniMax", miniMax, 30);
+	benchmarkSearch("miniMax", miniMax, 66);
+	benchmarkSearch("miniMaxIterative", searchIterative, 30);
+	benchmarkSearch("miniMaxIterative", searchIterative, 66);
+	benchmarkSearch("miniMaxPVS", searchPVS, 30);
+	benchmarkSearch("miniMaxPVS", searchPVS, 66);
+	benchmarkSweep();
+	benchmarkFreshTable();
+	benchmarkWarmStart();
+	benchmarkMakeBestMove();
+	benchmarkAnytime();
+	benchmarkSolver();
+	benchmarkBatch();
+	benchmarkPackedSolution();
+	benchmarkVariantSolver();
+	benchmarkPeriodic();
+	benchmarkServerRequests();
+
+	return 0;
+}